@@ -46,6 +46,10 @@
 #include "ev.h"
 #endif
 
+#if EV_COMPACT > 1
+#error "ev++.h needs the watcher data member, which EV_COMPACT 2 removes"
+#endif
+
 #ifndef EV_USE_STDEXCEPT
 #define EV_USE_STDEXCEPT 1
 #endif
@@ -76,6 +80,7 @@ enum {
   PREPARE = EV_PREPARE,
   FORK = EV_FORK,
   ASYNC = EV_ASYNC,
+  WORK = EV_WORK,
   EMBED = EV_EMBED,
 #undef ERROR  // some systems stupidly #define ERROR
   ERROR = EV_ERROR
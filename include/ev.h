@@ -51,6 +51,16 @@ EV_CPP(extern "C" {)
 #define EV_MAXPRI (EV_FEATURE_CONFIG ? +2 : 0)
 #endif
 
+/* smaller watchers, at the cost of binary compatibility: 1 packs pending and */
+/* priority into one 32 bit word, 2 also drops the data member */
+#ifndef EV_COMPACT
+#define EV_COMPACT 0
+#endif
+
+#if EV_COMPACT && (EV_MINPRI < -8 || EV_MAXPRI > 7)
+#error "libev: EV_COMPACT only has room for priorities -8..7"
+#endif
+
 #ifndef EV_MULTIPLICITY
 #define EV_MULTIPLICITY EV_FEATURE_CONFIG
 #endif
@@ -103,6 +113,26 @@ EV_CPP(extern "C" {)
 #define EV_EMBED_ENABLE EV_FEATURE_WATCHERS
 #endif
 
+#ifndef EV_CHANNEL_ENABLE
+#define EV_CHANNEL_ENABLE EV_FEATURE_WATCHERS
+#endif
+
+#ifndef EV_WORK_ENABLE
+#ifdef __ATOMIC_RELAXED /* the pool needs the __atomic builtins */
+#define EV_WORK_ENABLE EV_FEATURE_WATCHERS
+#else
+#define EV_WORK_ENABLE 0
+#endif
+#endif
+
+#ifndef EV_GROUP_ENABLE
+#define EV_GROUP_ENABLE EV_FEATURE_WATCHERS
+#endif
+
+#ifndef EV_DEFER_ENABLE
+#define EV_DEFER_ENABLE EV_FEATURE_WATCHERS
+#endif
+
 #ifndef EV_WALK_ENABLE
 #define EV_WALK_ENABLE 0 /* not yet */
 #endif
@@ -114,6 +144,24 @@ EV_CPP(extern "C" {)
 #define EV_SIGNAL_ENABLE 1
 #endif
 
+/* channels connect two loops and are built on ev_async */
+#if EV_CHANNEL_ENABLE && !(EV_ASYNC_ENABLE && EV_MULTIPLICITY)
+#undef EV_CHANNEL_ENABLE
+#define EV_CHANNEL_ENABLE 0
+#endif
+
+/* ev_work runs on posix threads and reports back through the loop's wakeup pipe */
+#if EV_WORK_ENABLE && !(EV_MULTIPLICITY && !defined(_WIN32))
+#undef EV_WORK_ENABLE
+#define EV_WORK_ENABLE 0
+#endif
+
+/* loop groups run one loop per thread and hand out fds via channels */
+#if EV_GROUP_ENABLE && (!EV_CHANNEL_ENABLE || defined(_WIN32))
+#undef EV_GROUP_ENABLE
+#define EV_GROUP_ENABLE 0
+#endif
+
 /*****************************************************************************/
 
 #ifndef EV_TSTAMP_T
@@ -189,6 +237,7 @@ enum {
   EV_NONE = 0x00,                                          /* no events */
   EV_READ = 0x01,                                          /* ev_io detected read will not block */
   EV_WRITE = 0x02,                                         /* ev_io detected write will not block */
+  EV_SPECULATIVE = 0x40,                                   /* ev_io stays ready until ev_io_eagain */
   EV__IOFDSET = (int)(1u << (sizeof(int) * CHAR_BIT - 2)), /* internal use only */
   EV_IO = EV_READ,                                         /* alias for type-detection */
   EV_TIMER = 0x00000100,                                   /* timer timed out */
@@ -206,14 +255,19 @@ enum {
   EV_FORK = 0x00020000,      /* event loop resumed in child */
   EV_CLEANUP = 0x00040000,   /* event loop resumed in child */
   EV_ASYNC = 0x00080000,     /* async intra-loop signal */
+  EV_WORK = 0x00100000,      /* work function finished on the pool */
   EV_CUSTOM = 0x01000000,    /* for use by user code */
   EV_ERROR = (int)0x80000000 /* sent when an error occurs */
 };
 
 /* can be used to add custom fields to all watchers, while losing binary compatibility */
 #ifndef EV_COMMON
+#if EV_COMPACT > 1
+#define EV_COMMON
+#else
 #define EV_COMMON void* data;
 #endif
+#endif
 
 #ifndef EV_CB_DECLARE
 #define EV_CB_DECLARE(type) void (*cb)(EV_P_ struct type * w, int revents);
@@ -245,13 +299,26 @@ enum {
 #if EV_MINPRI == EV_MAXPRI
 #define EV_DECL_PRIORITY
 #elif !defined(EV_DECL_PRIORITY)
+#if EV_COMPACT
+#define EV_DECL_PRIORITY signed int priority : 4;
+#else
 #define EV_DECL_PRIORITY int priority;
 #endif
+#endif
+
+/* with EV_COMPACT, at most 2**27-1 watchers can be pending per priority */
+#ifndef EV_DECL_PENDING
+#if EV_COMPACT && EV_MINPRI != EV_MAXPRI
+#define EV_DECL_PENDING signed int pending : 28;
+#else
+#define EV_DECL_PENDING int pending;
+#endif
+#endif
 
 /* shared by all watchers */
 #define EV_WATCHER(type)                \
   int active;             /* private */ \
-  int pending;            /* private */ \
+  EV_DECL_PENDING         /* private */ \
   EV_DECL_PRIORITY        /* private */ \
       EV_COMMON           /* rw */      \
       EV_CB_DECLARE(type) /* private */
@@ -414,6 +481,65 @@ typedef struct stat ev_statdata;
 #define ev_async_pending(w) (+(w)->sent)
 #endif
 
+#if EV_WORK_ENABLE
+  /* runs work on a pool thread, then invokes the callback in the loop */
+  /* revent EV_WORK */
+  typedef struct ev_work {
+    EV_WATCHER(ev_work)
+
+    void (*work)(struct ev_work* w); /* ro, called on a pool thread */
+    struct ev_loop* origin;          /* private */
+    struct ev_work* next;            /* private */
+    EV_ATOMIC_T cancelled;           /* private */
+  } ev_work;
+#endif
+
+#if EV_DEFER_ENABLE
+  /* one-shot call, made after the current ev_invoke_pending pass and before the */
+  /* loop polls again. not a watcher: it has no priority and does not keep the loop alive */
+  typedef struct ev_defer {
+    void (*cb)(EV_P_ struct ev_defer* d); /* rw */
+    struct ev_defer* next;                 /* private */
+    int queued;                            /* ro */
+    EV_COMMON                              /* rw */
+  } ev_defer;
+
+#define ev_defer_init(d, cb_) \
+  do {                        \
+    (d)->cb = (cb_);          \
+    (d)->queued = 0;          \
+  } while (0)
+
+#define ev_defer_is_queued(d) (+(d)->queued)
+#endif
+
+#if EV_CHANNEL_ENABLE
+  /* bounded single-producer/single-consumer message ring between two loops */
+  /* read_cb is invoked in the reader loop when messages became available (EV_READ), */
+  /* write_cb in the writer loop when a full ring has room again (EV_WRITE) */
+  typedef struct ev_channel {
+    ev_async reader;            /* private */
+    ev_async writer;            /* private */
+    struct ev_loop* read_loop;  /* private */
+    struct ev_loop* write_loop; /* private */
+    void (*read_cb)(EV_P_ struct ev_channel* c, int revents);  /* rw */
+    void (*write_cb)(EV_P_ struct ev_channel* c, int revents); /* rw */
+    void* data;                                                 /* rw */
+    char* buf;                                                  /* ro */
+    unsigned int size;                                          /* ro, bytes per message */
+    unsigned int mask;                                          /* ro, capacity - 1 */
+
+    /* producer and consumer state live on separate cache lines */
+    char pad0[64];
+    unsigned int volatile tail; /* private, written by the producer only */
+    unsigned int head_cache;    /* private, producer's view of head */
+    EV_ATOMIC_T want_space;     /* private, producer waits for room */
+    char pad1[64];
+    unsigned int volatile head; /* private, written by the consumer only */
+    unsigned int tail_cache;    /* private, consumer's view of tail */
+  } ev_channel;
+#endif
+
   /* the presence of this union forces similar struct layout */
   union ev_any_watcher {
     struct ev_watcher w;
@@ -443,12 +569,21 @@ typedef struct stat ev_statdata;
 #endif
 #if EV_ASYNC_ENABLE
     struct ev_async async;
+#endif
+#if EV_WORK_ENABLE
+    struct ev_work work;
 #endif
   };
 
   /* helper aliasing type for all watcher pointers */
   typedef union ev_any_watcher ev_any;
 
+  /* a pending watcher handed out by ev_poll_ready */
+  typedef struct {
+    ev_watcher* w;
+    int revents;
+  } ev_ready;
+
   /* flag bits for ev_default_loop and ev_loop_new */
   enum {
     /* the default */
@@ -456,6 +591,8 @@ typedef struct stat ev_statdata;
     /* flag bits */
     EVFLAG_NOENV = 0x01000000U,     /* do NOT consult environment */
     EVFLAG_FORKCHECK = 0x02000000U, /* check for a fork in each iteration */
+    EVFLAG_HUGEPAGES = 0x04000000U, /* back large arrays by transparent huge pages */
+    EVFLAG_NUMALOCAL = 0x08000000U, /* keep large arrays on the numa node of the thread growing them */
     /* debugging/feature disable */
     EVFLAG_NOINOTIFY = 0x00100000U, /* do not attempt to use inotify */
 #if EV_COMPAT3
@@ -481,6 +618,15 @@ typedef struct stat ev_statdata;
     EVBACKEND_MASK = 0x0000FFFFU      /* all future backends */
   };
 
+#if EV_GROUP_ENABLE
+  /* flag bits for ev_loop_group_new */
+  enum {
+    EVGROUP_ROUNDROBIN = 0x00000000U,  /* hand out fds to the loops in turn */
+    EVGROUP_LEASTLOADED = 0x00000001U, /* pick the loop with the fewest active watchers */
+    EVGROUP_PIN = 0x00000002U          /* pin each loop thread to its own cpu, where supported */
+  };
+#endif
+
 #if EV_PROTOTYPES
   EV_API_DECL int ev_version_major(void) EV_NOEXCEPT;
   EV_API_DECL int ev_version_minor(void) EV_NOEXCEPT;
@@ -506,6 +652,12 @@ typedef struct stat ev_statdata;
    */
   EV_API_DECL void ev_set_syserr_cb(void (*cb)(const char* msg) EV_NOEXCEPT) EV_NOEXCEPT;
 
+#if EV_WORK_ENABLE
+  /* number of ev_work pool threads, only effective before the first ev_work_start */
+  /* the default is the number of online cpus */
+  EV_API_DECL void ev_set_work_threads(int threads) EV_NOEXCEPT;
+#endif
+
 #if EV_MULTIPLICITY
 
   /* the default loop is the only one that handles signals and child watchers */
@@ -528,6 +680,11 @@ typedef struct stat ev_statdata;
 
   /* create and destroy alternative loops that don't handle signals */
   EV_API_DECL struct ev_loop* ev_loop_new(unsigned int flags EV_CPP(= 0)) EV_NOEXCEPT;
+  /* like ev_loop_new, but all memory owned by the loop (including the loop itself) */
+  /* comes from cb, which works like ev_set_allocator's and gets ctx passed through */
+  EV_API_DECL struct ev_loop* ev_loop_new_with_allocator(unsigned int flags,
+                                                         void* (*cb)(void* ptr, long size, void* ctx) EV_NOEXCEPT,
+                                                         void* ctx) EV_NOEXCEPT;
 
   EV_API_DECL ev_tstamp ev_now(EV_P) EV_NOEXCEPT; /* time w.r.t. timers and the eventloop, updated after each poll */
 
@@ -606,6 +763,25 @@ ev_is_default_loop (void) EV_NOEXCEPT
   EV_API_DECL void ev_once(EV_P_ int fd, int events, ev_tstamp timeout, void (*cb)(int revents, void* arg), void* arg)
       EV_NOEXCEPT;
 
+  /*
+   * like ev_once, but in storage provided by the caller, which must stay valid until
+   * cb is called, and may be freed or reused by cb
+   */
+  typedef struct ev_once_storage {
+    ev_io io;
+    ev_timer to;
+    void (*cb)(int revents, void* arg);
+    void* arg;
+    int pooled; /* private */
+  } ev_once_storage;
+
+  EV_API_DECL void ev_once_start(EV_P_ ev_once_storage* once,
+                                 int fd,
+                                 int events,
+                                 ev_tstamp timeout,
+                                 void (*cb)(int revents, void* arg),
+                                 void* arg) EV_NOEXCEPT;
+
   EV_API_DECL void ev_invoke_pending(EV_P); /* invoke all pending watchers */
 
 #if EV_FEATURE_API
@@ -613,10 +789,16 @@ ev_is_default_loop (void) EV_NOEXCEPT
   EV_API_DECL unsigned int ev_depth(EV_P) EV_NOEXCEPT;     /* #ev_loop enters - #ev_loop leaves */
   EV_API_DECL void ev_verify(EV_P) EV_NOEXCEPT;            /* abort if loop data corrupted */
 
+  /* one loop iteration without prepare/check/idle, returning up to max pending */
+  /* watchers without callback instead of invoking them, all others get invoked */
+  EV_API_DECL int ev_poll_ready(EV_P_ ev_ready* out, int max, ev_tstamp timeout);
+
   EV_API_DECL void ev_set_io_collect_interval(EV_P_ ev_tstamp interval)
       EV_NOEXCEPT; /* sleep at least this time, default 0 */
   EV_API_DECL void ev_set_timeout_collect_interval(EV_P_ ev_tstamp interval)
       EV_NOEXCEPT; /* sleep at least this time, default 0 */
+  EV_API_DECL void ev_set_busy_poll(EV_P_ ev_tstamp budget)
+      EV_NOEXCEPT; /* spin this long before blocking, default 0 */
 
   /* advanced stuff for threading etc. support, see docs */
   EV_API_DECL void ev_set_userdata(EV_P_ void* data) EV_NOEXCEPT;
@@ -629,6 +811,21 @@ ev_is_default_loop (void) EV_NOEXCEPT
 
   EV_API_DECL unsigned int ev_pending_count(EV_P) EV_NOEXCEPT; /* number of pending events, if any */
 
+  /* cap the callbacks (0 = no limit) and time (0. = no limit) spent per ev_invoke_pending */
+  EV_API_DECL void ev_set_invoke_budget(EV_P_ unsigned int callbacks, ev_tstamp interval) EV_NOEXCEPT;
+  EV_API_DECL unsigned long ev_invoke_deferred(EV_P) EV_NOEXCEPT; /* pendings left behind by the budget */
+
+  /* weighted round-robin instead of strict priorities once any weight is non-zero */
+  EV_API_DECL void ev_set_priority_weight(EV_P_ int priority, unsigned int weight) EV_NOEXCEPT;
+
+  /* earliest-deadline-first dispatch once any priority has a latency budget */
+  EV_API_DECL void ev_set_priority_deadline(EV_P_ int priority, ev_tstamp budget) EV_NOEXCEPT;
+  EV_API_DECL void ev_feed_event_deadline(EV_P_ void* w, int revents, ev_tstamp deadline) EV_NOEXCEPT;
+
+  /* pre-size loop-internal arrays, and give back what load peaks left behind (but not below the reservation) */
+  EV_API_DECL void ev_loop_reserve(EV_P_ int nfds, int ntimers, int npending) EV_NOEXCEPT;
+  EV_API_DECL void ev_loop_trim(EV_P) EV_NOEXCEPT;
+
   /*
    * stop/start the timer handling.
    */
@@ -709,6 +906,11 @@ ev_is_default_loop (void) EV_NOEXCEPT
 #define ev_cleanup_set(ev)
 #define ev_async_set(ev)
 
+#define ev_work_set(ev, work_) \
+  do {                         \
+    (ev)->work = (work_);      \
+  } while (0)
+
 #define ev_io_init(ev, cb, fd, events) \
   do {                                 \
     ev_init((ev), (cb));               \
@@ -787,6 +989,12 @@ ev_is_default_loop (void) EV_NOEXCEPT
     ev_async_set((ev));       \
   } while (0)
 
+#define ev_work_init(ev, cb, work) \
+  do {                             \
+    ev_init((ev), (cb));           \
+    ev_work_set((ev), (work));     \
+  } while (0)
+
 #define ev_is_pending(ev) \
   (0 + ((ev_any*)(void*)(ev))->w.pending)
 
@@ -846,6 +1054,15 @@ ev_is_default_loop (void) EV_NOEXCEPT
 
   EV_API_DECL void ev_io_start(EV_P_ ev_io * w) EV_NOEXCEPT;
   EV_API_DECL void ev_io_stop(EV_P_ ev_io * w) EV_NOEXCEPT;
+#if EV_FEATURE_API
+  /* an EV_SPECULATIVE watcher ran into EAGAIN, wait for the kernel again */
+  EV_API_DECL void ev_io_eagain(EV_P_ ev_io * w) EV_NOEXCEPT;
+#endif
+#if EV_MULTIPLICITY
+  /* move all io watchers of fd, with their pending events, to the other loop */
+  /* returns the number of watchers moved, or -1 if other cannot be woken up */
+  EV_API_DECL int ev_io_migrate(EV_P_ int fd, struct ev_loop* other) EV_NOEXCEPT;
+#endif
 
   EV_API_DECL void ev_timer_start(EV_P_ ev_timer * w) EV_NOEXCEPT;
   EV_API_DECL void ev_timer_stop(EV_P_ ev_timer * w) EV_NOEXCEPT;
@@ -916,6 +1133,51 @@ ev_is_default_loop (void) EV_NOEXCEPT
   EV_API_DECL void ev_async_send(EV_P_ ev_async * w) EV_NOEXCEPT;
 #endif
 
+#if EV_WORK_ENABLE
+  /* stopping only skips the work function if it has not started yet, and suppresses */
+  /* the callback. the watcher stays active until the pool is done with it */
+  EV_API_DECL void ev_work_start(EV_P_ ev_work * w) EV_NOEXCEPT;
+  EV_API_DECL void ev_work_stop(EV_P_ ev_work * w) EV_NOEXCEPT;
+#endif
+
+#if EV_DEFER_ENABLE
+  /* queue a deferred call, unless already queued. calls run in fifo order */
+  EV_API_DECL void ev_defer_call(EV_P_ ev_defer * d) EV_NOEXCEPT;
+  /* unqueue a deferred call, walks the queue */
+  EV_API_DECL void ev_defer_cancel(EV_P_ ev_defer * d) EV_NOEXCEPT;
+  /* at most this many deferred calls per drain, 0 means no limit, default 1024 */
+  EV_API_DECL void ev_set_defer_limit(EV_P_ unsigned int calls) EV_NOEXCEPT;
+#endif
+
+#if EV_CHANNEL_ENABLE
+  /* capacity must be a power of two, buf must hold capacity * size bytes */
+  EV_API_DECL void ev_channel_init(ev_channel * c, void* buf, unsigned int size, unsigned int capacity,
+                                   void (*read_cb)(EV_P_ ev_channel* c, int revents),
+                                   void (*write_cb)(EV_P_ ev_channel* c, int revents)) EV_NOEXCEPT;
+  /* attach the consuming/producing side to the loop (and thread) it is used from */
+  EV_API_DECL void ev_channel_reader_start(EV_P_ ev_channel * c) EV_NOEXCEPT;
+  EV_API_DECL void ev_channel_reader_stop(EV_P_ ev_channel * c) EV_NOEXCEPT;
+  EV_API_DECL void ev_channel_writer_start(EV_P_ ev_channel * c) EV_NOEXCEPT;
+  EV_API_DECL void ev_channel_writer_stop(EV_P_ ev_channel * c) EV_NOEXCEPT;
+  /* copy up to n messages in/out, returns the number of messages copied */
+  EV_API_DECL unsigned int ev_channel_write(ev_channel * c, const void* msgs, unsigned int n) EV_NOEXCEPT;
+  EV_API_DECL unsigned int ev_channel_read(ev_channel * c, void* msgs, unsigned int max) EV_NOEXCEPT;
+#endif
+
+#if EV_GROUP_ENABLE
+  struct ev_loop_group;
+
+  /* creates nloops loops with the given loop flags, conn_cb gets invoked in the */
+  /* receiving loop for every fd passed to ev_loop_group_dispatch */
+  EV_API_DECL struct ev_loop_group* ev_loop_group_new(int nloops, unsigned int loop_flags, unsigned int group_flags,
+                                                      void (*conn_cb)(EV_P_ int fd, void* arg), void* arg) EV_NOEXCEPT;
+  EV_API_DECL int ev_loop_group_count(struct ev_loop_group * g) EV_NOEXCEPT;
+  EV_API_DECL struct ev_loop* ev_loop_group_loop(struct ev_loop_group * g, int idx) EV_NOEXCEPT;
+  EV_API_DECL int ev_loop_group_start(struct ev_loop_group * g) EV_NOEXCEPT;    /* spawns the threads, 0 or -1 */
+  EV_API_DECL int ev_loop_group_dispatch(struct ev_loop_group * g, int fd) EV_NOEXCEPT; /* loop index or -1 */
+  EV_API_DECL void ev_loop_group_destroy(struct ev_loop_group * g) EV_NOEXCEPT;
+#endif
+
 #if EV_COMPAT3
 #define EVLOOP_NONBLOCK EVRUN_NOWAIT
 #define EVLOOP_ONESHOT EVRUN_ONCE
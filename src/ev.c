@@ -343,6 +343,14 @@
 #define EV_INOTIFY_HASHSIZE EV_FEATURE_DATA ? 16 : 1
 #endif
 
+#ifndef EV_ASYNC_HASHSIZE
+#define EV_ASYNC_HASHSIZE EV_FEATURE_DATA ? 4096 : 64
+#endif
+
+#ifndef EV_GROUP_QUEUESIZE
+#define EV_GROUP_QUEUESIZE EV_FEATURE_DATA ? 1024 : 64
+#endif
+
 #ifndef EV_USE_EVENTFD
 #if __linux && (__GLIBC__ > 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ >= 7))
 #define EV_USE_EVENTFD EV_FEATURE_OS
@@ -367,6 +375,14 @@
 #endif
 #endif
 
+#ifndef EV_USE_HUGEPAGES
+#if __linux
+#define EV_USE_HUGEPAGES EV_FEATURE_OS
+#else
+#define EV_USE_HUGEPAGES 0
+#endif
+#endif
+
 #if 0 /* debugging */
 #define EV_VERIFY 3
 #define EV_USE_4HEAP 1
@@ -385,6 +401,10 @@
 #define EV_HEAP_CACHE_AT EV_FEATURE_DATA
 #endif
 
+#ifndef EV_FD_PAGES
+#define EV_FD_PAGES 0
+#endif
+
 #ifdef __ANDROID__
 /* supposedly, android doesn't typedef fd_mask */
 #undef EV_USE_SELECT
@@ -473,6 +493,15 @@
 #endif
 #endif
 
+#if EV_USE_HUGEPAGES
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#ifndef MADV_HUGEPAGE
+#undef EV_USE_HUGEPAGES
+#define EV_USE_HUGEPAGES 0
+#endif
+#endif
+
 #if EV_USE_INOTIFY
 #include <sys/statfs.h>
 #include <sys/inotify.h>
@@ -1926,6 +1955,62 @@ ecb_function_ ecb_const float ecb_binary16_to_float(uint16_t x) {
 #define ECB_MEMORY_FENCE_RELEASE ECB_MEMORY_FENCE
 #endif
 
+/* atomics, used for the ev_async sent map, the io migration queue and the ev_work pool */
+#if ECB_GCC_VERSION(4, 7) || ECB_CLANG_EXTENSION(c_atomic)
+#define ev_atomic_or(ptr, v) __atomic_fetch_or((ptr), (v), __ATOMIC_RELEASE)
+#define ev_atomic_xchg(ptr, v) __atomic_exchange_n((ptr), (v), __ATOMIC_ACQUIRE)
+#define ev_atomic_cas(ptr, expp, v) __atomic_compare_exchange_n((ptr), (expp), (v), 0, __ATOMIC_RELEASE, __ATOMIC_RELAXED)
+#define ev_atomic_add(ptr, v) __atomic_fetch_add((ptr), (v), __ATOMIC_RELEASE)
+#define ev_atomic_sub(ptr, v) __atomic_fetch_sub((ptr), (v), __ATOMIC_RELAXED)
+#define ev_atomic_load(ptr) __atomic_load_n((ptr), __ATOMIC_ACQUIRE)
+#define ev_atomic_store(ptr, v) __atomic_store_n((ptr), (v), __ATOMIC_RELEASE)
+#define EV_HAVE_ATOMIC_RMW 1
+#else
+#define EV_HAVE_ATOMIC_RMW 0
+#endif
+
+#ifndef EV_USE_ASYNC_MAP
+#define EV_USE_ASYNC_MAP (EV_ASYNC_ENABLE && EV_HAVE_ATOMIC_RMW)
+#endif
+
+/* ev_io_migrate pushes watchers onto the target loop's queue and wakes it via its evpipe */
+#define EV_USE_IO_MIGRATE (EV_MULTIPLICITY && EV_ASYNC_ENABLE && EV_HAVE_ATOMIC_RMW)
+/* revents carried along are parked above the event bits of a migrating watcher */
+#define EV__IOMIGRATED_SHIFT 8
+
+/* an EV_SPECULATIVE watcher on the hot list */
+#define EV__IOHOT 0x80
+/* while fds are hot, only poll the kernel every this many iterations */
+#define HOT_POLL_EVERY 16
+
+#if EV_USE_ASYNC_MAP
+#if !EV_HAVE_ATOMIC_RMW
+#error "EV_USE_ASYNC_MAP requires atomic builtins"
+#endif
+#if (EV_ASYNC_HASHSIZE) & ((EV_ASYNC_HASHSIZE) - 1) || (EV_ASYNC_HASHSIZE) < 64 || (EV_ASYNC_HASHSIZE) > 4096
+#error "EV_ASYNC_HASHSIZE must be a power of two between 64 and 4096"
+#endif
+/* two-level bitmap: one summary word, one bit per map word */
+#define EV_ASYNC_MAPWORDS ((EV_ASYNC_HASHSIZE) / 64)
+#endif
+
+#if EV_WORK_ENABLE
+#include <pthread.h>
+#if !EV_HAVE_ATOMIC_RMW
+#error "ev_work requires atomic builtins, compile with EV_WORK_ENABLE=0"
+#endif
+#endif
+
+#if EV_GROUP_ENABLE
+#include <pthread.h>
+#ifdef __linux__
+#include <sys/syscall.h>
+#endif
+#if (EV_GROUP_QUEUESIZE) & ((EV_GROUP_QUEUESIZE) - 1)
+#error "EV_GROUP_QUEUESIZE must be a power of two"
+#endif
+#endif
+
 #define inline_size ecb_inline
 
 #if EV_FEATURE_CODE
@@ -1970,6 +2055,11 @@ inline_size int ev_syscall_ret(long res) {
 
 #define NUMPRI (EV_MAXPRI - EV_MINPRI + 1)
 
+/* pending priorities are tracked in an unsigned int bitmap */
+#if NUMPRI > 32
+#error "EV_MAXPRI - EV_MINPRI must be < 32"
+#endif
+
 #if EV_MINPRI == EV_MAXPRI
 #define ABSPRI(w) (((W)(w)), 0)
 #else
@@ -2155,17 +2245,21 @@ ecb_cold void ev_set_allocator(void* (*cb)(void* ptr, long size)EV_NOEXCEPT) EV_
   alloc = cb;
 }
 
-inline_speed void* ev_realloc(void* ptr, long size) {
-  ptr = alloc(ptr, size);
-
-  if (!ptr && size) {
+ecb_noinline ecb_cold static void ev_alloc_fail(long size) {
 #if EV_AVOID_STDIO
-    ev_printerr("(libev) memory allocation failed, aborting.\n");
+  (void)size;
+  ev_printerr("(libev) memory allocation failed, aborting.\n");
 #else
-    fprintf(stderr, "(libev) cannot allocate %ld bytes, aborting.", size);
+  fprintf(stderr, "(libev) cannot allocate %ld bytes, aborting.", size);
 #endif
-    abort();
-  }
+  abort();
+}
+
+inline_speed void* ev_realloc(void* ptr, long size) {
+  ptr = alloc(ptr, size);
+
+  if (!ptr && size)
+    ev_alloc_fail(size);
 
   return ptr;
 }
@@ -2177,24 +2271,59 @@ inline_speed void* ev_realloc(void* ptr, long size) {
 
 /* set in reify when reification needed */
 #define EV_ANFD_REIFY 1
+/* set in reify when the fd has to be registered with the backend from scratch */
+#define EV_ANFD_IOFDSET 2
 
-/* file descriptor info structure */
+/* file descriptor info structure, only what fd_event, fd_reify and the */
+/* poll loops of the backends need, so that it packs densely (16 bytes on lp64) */
 typedef struct {
   WL head;
-  unsigned char events; /* the events watched for */
-  unsigned char emask;  /* some backends store the actual kernel mask in here */
-  unsigned char eflags; /* flags field for use by backends */
-  unsigned int reify;   /* flag set when this ANFD needs reification (EV_ANFD_REIFY, EV__IOFDSET) */
 #if EV_USE_EPOLL
   unsigned int egen; /* generation counter to counter epoll bugs */
 #endif
+  unsigned char events; /* the events watched for */
+  unsigned char emask;  /* some backends store the actual kernel mask in here */
+  unsigned char reify;  /* flags set when this ANFD needs reification (EV_ANFD_REIFY, EV_ANFD_IOFDSET) */
+} ANFD;
+
+/* active watchers per direction, so fd_reify knows the new mask without walking the list */
+typedef struct {
+  unsigned int readers;
+  unsigned int writers;
+} ANFDCNT;
+
+#if EV_FD_PAGES
+/* anfds is a directory of pages, pages never touched all share one zeroed page, */
+/* so lookups need no checks and memory follows the fds actually watched */
+#define ANFD_PAGE_SHIFT 10
+#define ANFD_PAGE (1 << ANFD_PAGE_SHIFT)
+typedef struct {
+  ANFD anfd[ANFD_PAGE];
+  ANFDCNT cnt[ANFD_PAGE];
+} ANFDPAGE;
+#define ANFD_AT(fd) anfds[(fd) >> ANFD_PAGE_SHIFT]->anfd[(fd) & (ANFD_PAGE - 1)]
+#define ANFDCNT_AT(fd) anfds[(fd) >> ANFD_PAGE_SHIFT]->cnt[(fd) & (ANFD_PAGE - 1)]
+typedef ANFDPAGE* ANFDSLOT;
+static const ANFDPAGE anfd_zero_page;
+#else
+/* the counts live in anfdcnts, parallel to anfds, as only start/stop/reify need them */
+#define ANFD_AT(fd) anfds[fd]
+#define ANFDCNT_AT(fd) anfdcnts[fd]
+typedef ANFD ANFDSLOT;
+#endif
+
 #if EV_SELECT_IS_WINSOCKET || EV_USE_IOCP
+#define EV_USE_ANFDX 1
+/* backend-only per-fd state, kept in anfdxs in parallel to anfds */
+typedef struct {
   SOCKET handle;
-#endif
 #if EV_USE_IOCP
   OVERLAPPED or, ow;
 #endif
-} ANFD;
+} ANFDX;
+#else
+#define EV_USE_ANFDX 0
+#endif
 
 /* stores the pending event set for a given watcher */
 typedef struct {
@@ -2202,6 +2331,21 @@ typedef struct {
   int events; /* the pending event set for the given watcher */
 } ANPENDING;
 
+#if EV_FEATURE_API
+/* entry of the earliest-deadline-first dispatch heap */
+typedef struct {
+  ev_tstamp deadline;
+  int pri;
+  int idx; /* index into pendings[pri] */
+} ANEDF;
+
+/* speculative ev_io assumed to be still ready */
+typedef struct {
+  ev_io* w;
+  int events;
+} ANHOT;
+#endif
+
 #if EV_USE_INOTIFY
 /* hash table entry per inotify-id */
 typedef struct {
@@ -2276,6 +2420,25 @@ static int ev_default_loop_ptr;
 
 #define EVBREAK_RECURSE 0x80
 
+/* memory owned by a loop goes through its own allocator, if it was given one */
+inline_speed void* loop_realloc(EV_P_ void* ptr, long size) {
+#if EV_MULTIPLICITY
+  if (ecb_expect_false(alloc_cb)) {
+    ptr = alloc_cb(ptr, size, alloc_ctx);
+
+    if (!ptr && size)
+      ev_alloc_fail(size);
+
+    return ptr;
+  }
+#endif
+
+  return ev_realloc(ptr, size);
+}
+
+#define loop_malloc(size) loop_realloc(EV_A_ 0, (size))
+#define loop_free(ptr) loop_realloc(EV_A_(ptr), 0)
+
 /*****************************************************************************/
 
 #include "ev_time.c"
@@ -2319,4 +2482,8 @@ static int ev_default_loop_ptr;
 #include "ev_select.c"
 #endif
 
+#include "ev_channel.c"
+#include "ev_work.c"
+#include "ev_group.c"
+
 #include "ev_api.c"
@@ -104,6 +104,88 @@ void ev_set_timeout_collect_interval(EV_P_ ev_tstamp interval) EV_NOEXCEPT {
   timeout_blocktime = interval;
 }
 
+void ev_set_busy_poll(EV_P_ ev_tstamp budget) EV_NOEXCEPT {
+  busy_polltime = budget > EV_TS_CONST(0.) ? budget : EV_TS_CONST(0.);
+
+#if EV_USE_EPOLL
+  if (backend == EVBACKEND_EPOLL)
+    epoll_busy_poll(EV_A);
+#endif
+}
+
+void ev_set_invoke_budget(EV_P_ unsigned int callbacks, ev_tstamp interval) EV_NOEXCEPT {
+  invoke_budget = callbacks;
+  invoke_timebudget = interval > EV_TS_CONST(0.) ? interval : EV_TS_CONST(0.);
+  invoke_leftover = 0;
+}
+
+unsigned long ev_invoke_deferred(EV_P) EV_NOEXCEPT {
+  return invoke_deferred;
+}
+
+/* from now on, keep a deadline for every pending watcher */
+ecb_cold static void edf_track_start(EV_P) {
+  int pri, i;
+
+  if (edf_tracked)
+    return;
+
+  edf_tracked = 1;
+
+  for (pri = NUMPRI; pri--;)
+    for (i = 0; i < pendingcnt[pri]; ++i)
+      edf_track(EV_A_ pri, i, EV_TS_CONST(0.));
+}
+
+void ev_set_priority_deadline(EV_P_ int priority, ev_tstamp budget) EV_NOEXCEPT {
+  int was_active = edf_active;
+  int pri;
+
+  pri_deadline[ev_clamp_priority(priority) - EV_MINPRI] = budget > EV_TS_CONST(0.) ? budget : EV_TS_CONST(0.);
+  edf_active = 0;
+
+  for (pri = NUMPRI; pri--;)
+    edf_active |= pri_deadline[pri] > EV_TS_CONST(0.);
+
+  /* watchers queued while edf was off get their budget, unless fed with an explicit deadline */
+  if (edf_active && !was_active) {
+    edf_track_start(EV_A);
+
+    for (pri = NUMPRI; pri--;) {
+      int i;
+
+      for (i = 0; i < pendingcnt[pri]; ++i)
+        if (pendingdls[pri][i] == EV_TS_CONST(0.))
+          pendingdls[pri][i] = ev_rt_now + pri_deadline[pri];
+    }
+  }
+}
+
+void ev_feed_event_deadline(EV_P_ void* w, int revents, ev_tstamp deadline) EV_NOEXCEPT {
+  W w_ = (W)w;
+  int was_pending = w_->pending;
+  ev_tstamp* dl;
+
+  edf_track_start(EV_A);
+  ev_feed_event(EV_A_ w, revents);
+
+  /* an already pending watcher keeps the earlier of both deadlines */
+  dl = pendingdls[ABSPRI(w_)] + w_->pending - 1;
+
+  if (!was_pending || *dl == EV_TS_CONST(0.) || deadline < *dl)
+    *dl = deadline;
+}
+
+void ev_set_priority_weight(EV_P_ int priority, unsigned int weight) EV_NOEXCEPT {
+  int pri;
+
+  pri_weight[ev_clamp_priority(priority) - EV_MINPRI] = weight;
+  pri_weighted = 0;
+
+  for (pri = NUMPRI; pri--;)
+    pri_weighted |= !!pri_weight[pri];
+}
+
 void ev_set_userdata(EV_P_ void* data) EV_NOEXCEPT {
   userdata = data;
 }
@@ -120,6 +202,92 @@ void ev_set_loop_release_cb(EV_P_ void (*release)(EV_P) EV_NOEXCEPT, void (*acqu
   release_cb = release;
   acquire_cb = acquire;
 }
+
+ecb_cold void ev_loop_reserve(EV_P_ int nfds, int ntimers, int npending) EV_NOEXCEPT {
+  int pri;
+
+  if (nfds > 0) {
+#if EV_FD_PAGES
+    int fd;
+
+    for (fd = 0; fd < nfds; fd += ANFD_PAGE)
+      fd_need(EV_A_ fd);
+#endif
+    fd_need(EV_A_ nfds - 1);
+    array_needsize(uint64_t, fdbits, fdbitmax, (nfds + 63) >> 6, array_needsize_zerofill);
+    array_needsize(uint64_t, fdsums, fdsummax, (fdbitmax + 63) >> 6, array_needsize_zerofill);
+    array_needsize(int, fdchanges, fdchangemax, nfds, array_needsize_noinit);
+#if EV_USE_EPOLL
+    if (epoll_eventmax && epoll_eventmax < nfds)
+      epoll_events_resize(EV_A_ nfds);
+#endif
+#if EV_USE_KQUEUE
+    if (kqueue_eventmax && kqueue_eventmax < nfds)
+      kqueue_events_resize(EV_A_ nfds);
+#endif
+    reserve_fds = nfds;
+  }
+
+  if (ntimers > 0) {
+    array_needsize_huge(ANHE, timers, timermax, ntimers + HEAP0, array_needsize_noinit);
+    reserve_timers = ntimers;
+  }
+
+  if (npending > 0) {
+    for (pri = NUMPRI; pri--;)
+      array_needsize(ANPENDING, pendings[pri], pendingmax[pri], npending, array_needsize_noinit);
+
+    reserve_pending = npending;
+  }
+}
+
+/* arrays in use during callbacks only hold cnt valid entries, so this is safe anywhere */
+ecb_cold void ev_loop_trim(EV_P) EV_NOEXCEPT {
+  int pri;
+
+  for (pri = NUMPRI; pri--;) {
+    array_shrink(ANPENDING, pending, [pri], pendingcnt[pri], reserve_pending);
+#if EV_FEATURE_API
+    array_shrink(ev_tstamp, pendingdl, [pri], edf_tracked ? pendingcnt[pri] : 0, 0);
+#endif
+#if EV_IDLE_ENABLE
+    array_shrink(ev_idle*, idle, [pri], idlecnt[pri], 0);
+#endif
+  }
+
+  array_shrink(W, rfeed, EMPTY, rfeedcnt, 0);
+  array_shrink(int, fdchange, EMPTY, fdchangecnt, reserve_fds);
+  array_shrink_huge(ANHE, timer, EMPTY, timercnt + HEAP0, reserve_timers + HEAP0);
+#if EV_PERIODIC_ENABLE
+  array_shrink(ANHE, periodic, EMPTY, periodiccnt + HEAP0, 0);
+#endif
+#if EV_FORK_ENABLE
+  array_shrink(ev_fork*, fork, EMPTY, forkcnt, 0);
+#endif
+#if EV_CLEANUP_ENABLE
+  array_shrink(ev_cleanup*, cleanup, EMPTY, cleanupcnt, 0);
+#endif
+#if EV_PREPARE_ENABLE
+  array_shrink(ev_prepare*, prepare, EMPTY, preparecnt, 0);
+#endif
+#if EV_CHECK_ENABLE
+  array_shrink(ev_check*, check, EMPTY, checkcnt, 0);
+#endif
+#if EV_ASYNC_ENABLE
+  array_shrink(ev_async*, async, EMPTY, asynccnt, 0);
+#endif
+  array_shrink(ANEDF, edf, EMPTY, edfcnt, 0);
+  array_shrink(ANHOT, hot, EMPTY, hotcnt, 0);
+
+#if EV_USE_EPOLL
+  if (epoll_eventmax > 64 && epoll_eventmax > reserve_fds)
+    epoll_events_resize(EV_A_ reserve_fds > 64 ? reserve_fds : 64);
+#endif
+#if EV_USE_KQUEUE
+  if (kqueue_eventmax > 64 && kqueue_eventmax > reserve_fds)
+    kqueue_events_resize(EV_A_ reserve_fds > 64 ? reserve_fds : 64);
+#endif
+}
 #endif
 
 /* initialise a loop structure, must be zero-initialised */
@@ -160,15 +328,30 @@ ecb_noinline ecb_cold static void loop_init(EV_P_ unsigned int flags) EV_NOEXCEP
     rtmn_diff = ev_rt_now - mn_now;
 #if EV_FEATURE_API
     invoke_cb = ev_invoke_pending;
+    invoke_budget = 0;
+    invoke_timebudget = 0.;
+    invoke_deferred = 0;
+    invoke_leftover = 0;
+    pri_weighted = 0;
+    pri_cursor = NUMPRI - 1;
+    edf_active = 0;
+    edf_tracked = 0;
+    hotpolls = 0;
 #endif
 
     io_blocktime = 0.;
     timeout_blocktime = 0.;
+    busy_polltime = 0.;
     backend = 0;
     backend_fd = -1;
     sig_pending = 0;
 #if EV_ASYNC_ENABLE
     async_pending = 0;
+#endif
+#if EV_DEFER_ENABLE
+    defer_head = 0;
+    defer_tail = &defer_head;
+    defer_limit = 1024;
 #endif
     pipe_write_skipped = 0;
     pipe_write_wanted = 0;
@@ -267,6 +450,9 @@ ecb_cold void ev_loop_destroy(EV_P) {
 #if EV_USE_SIGNALFD
   if (ev_is_active(&sigfd_w))
     close(sigfd);
+
+  loop_free(sigfd_set);
+  sigfd_set = 0;
 #endif
 
 #if EV_USE_TIMERFD
@@ -277,6 +463,9 @@ ecb_cold void ev_loop_destroy(EV_P) {
 #if EV_USE_INOTIFY
   if (fs_fd >= 0)
     close(fs_fd);
+
+  loop_free(fs_hash);
+  fs_hash = 0;
 #endif
 
   if (backend_fd >= 0)
@@ -317,19 +506,62 @@ ecb_cold void ev_loop_destroy(EV_P) {
 
   for (i = NUMPRI; i--;) {
     array_free(pending, [i]);
+#if EV_FEATURE_API
+    loop_free(pendingdls[i]);
+    pendingdls[i] = 0;
+    pendingdlmax[i] = 0;
+#endif
 #if EV_IDLE_ENABLE
     array_free(idle, [i]);
 #endif
   }
 
-  ev_free(anfds);
+#if EV_FEATURE_API
+  array_free(edf, EMPTY);
+  array_free(hot, EMPTY);
+#endif
+
+  while (once_slabs) {
+    void* next = *(void**)once_slabs;
+
+    loop_free(once_slabs);
+    once_slabs = next;
+  }
+
+  once_free = 0;
+
+#if EV_FD_PAGES
+  while (anfdpagemax--)
+    if (anfds[anfdpagemax] != &anfd_zero_page)
+      loop_free(anfds[anfdpagemax]);
+
+  anfdpagemax = 0;
+  loop_free(anfds);
+#else
+  {
+    int cntmax = anfdmax;
+
+    anfdcnts = (ANFDCNT*)array_resize_huge(EV_A_ sizeof(ANFDCNT), anfdcnts, &cntmax, 0);
+    anfds = (ANFD*)array_resize_huge(EV_A_ sizeof(ANFD), anfds, &anfdmax, 0);
+  }
+#endif
   anfds = 0;
   anfdmax = 0;
+  loop_free(fdbits);
+  loop_free(fdsums);
+  fdbits = fdsums = 0;
+  fdbitmax = fdsummax = 0;
+#if EV_USE_ANFDX
+  loop_free(anfdxs);
+  anfdxs = 0;
+  anfdxmax = 0;
+#endif
 
   /* have to use the microsoft-never-gets-it-right macro */
   array_free(rfeed, EMPTY);
   array_free(fdchange, EMPTY);
-  array_free(timer, EMPTY);
+  timers = (ANHE*)array_resize_huge(EV_A_ sizeof(ANHE), timers, &timermax, 0);
+  timercnt = 0;
 #if EV_PERIODIC_ENABLE
   array_free(periodic, EMPTY);
 #endif
@@ -344,6 +576,11 @@ ecb_cold void ev_loop_destroy(EV_P) {
 #if EV_ASYNC_ENABLE
   array_free(async, EMPTY);
 #endif
+#if EV_USE_ASYNC_MAP
+  loop_free(async_map);
+  async_map = 0;
+  async_mapsum = 0;
+#endif
 
   backend = 0;
 
@@ -353,7 +590,7 @@ ecb_cold void ev_loop_destroy(EV_P) {
     ev_default_loop_ptr = 0;
 #if EV_MULTIPLICITY
   else
-    ev_free(EV_A);
+    loop_free(EV_A);
 #endif
 }
 
@@ -427,19 +664,30 @@ inline_size void loop_fork(EV_P) {
 
 #if EV_MULTIPLICITY
 
-ecb_cold struct ev_loop* ev_loop_new(unsigned int flags) EV_NOEXCEPT {
-  EV_P = (struct ev_loop*)ev_malloc(sizeof(struct ev_loop));
+ecb_cold struct ev_loop* ev_loop_new_with_allocator(unsigned int flags,
+                                                    void* (*cb)(void* ptr, long size, void* ctx) EV_NOEXCEPT,
+                                                    void* ctx) EV_NOEXCEPT {
+  EV_P = (struct ev_loop*)(cb ? cb(0, sizeof(struct ev_loop), ctx) : ev_malloc(sizeof(struct ev_loop)));
+
+  if (!EV_A)
+    return 0;
 
   memset(EV_A, 0, sizeof(struct ev_loop));
+  alloc_cb = cb;
+  alloc_ctx = ctx;
   loop_init(EV_A_ flags);
 
   if (ev_backend(EV_A))
     return EV_A;
 
-  ev_free(EV_A);
+  loop_free(EV_A);
   return 0;
 }
 
+ecb_cold struct ev_loop* ev_loop_new(unsigned int flags) EV_NOEXCEPT {
+  return ev_loop_new_with_allocator(flags, 0, 0);
+}
+
 #endif /* multiplicity */
 
 #if EV_VERIFY
@@ -485,9 +733,12 @@ void ecb_cold ev_verify(EV_P) EV_NOEXCEPT {
   assert(anfdmax >= 0);
   for (i = 0; i < anfdmax; ++i) {
     int j = 0;
+    unsigned int readers = 0, writers = 0;
 
-    for (w = w2 = anfds[i].head; w; w = w->next) {
+    for (w = w2 = ANFD_AT(i).head; w; w = w->next) {
       verify_watcher(EV_A_(W) w);
+      readers += !!(((ev_io*)w)->events & EV_READ);
+      writers += !!(((ev_io*)w)->events & EV_WRITE);
 
       if (j++ & 1) {
         EV_ASSERT_MSG("libev: io watcher list contains a loop", w != w2);
@@ -497,6 +748,12 @@ void ecb_cold ev_verify(EV_P) EV_NOEXCEPT {
       EV_ASSERT_MSG("libev: inactive fd watcher on anfd list", ev_active(w) == 1);
       EV_ASSERT_MSG("libev: fd mismatch between watcher and anfd", ((ev_io*)w)->fd == i);
     }
+
+    if (ANFD_AT(i).head || ANFD_AT(i).events)
+      EV_ASSERT_MSG("libev: watched fd missing from the fd index", fd_next(EV_A_ i) == i);
+
+    EV_ASSERT_MSG("libev: reader/writer counts out of sync with the anfd list",
+                  ANFDCNT_AT(i).readers == readers && ANFDCNT_AT(i).writers == writers);
   }
 
   assert(timermax >= timercnt);
@@ -509,6 +766,7 @@ void ecb_cold ev_verify(EV_P) EV_NOEXCEPT {
 
   for (i = NUMPRI; i--;) {
     assert(pendingmax[i] >= pendingcnt[i]);
+    assert(!(pendingbits & (1U << i)) == !pendingcnt[i]);
 #if EV_IDLE_ENABLE
     assert(idleall >= 0);
     assert(idlemax[i] >= idlecnt[i]);
@@ -601,21 +859,310 @@ unsigned int ev_pending_count(EV_P) EV_NOEXCEPT {
   return count;
 }
 
-ecb_noinline void ev_invoke_pending(EV_P) {
-  pendingpri = NUMPRI;
+/* pops the most recently queued watcher of priority pri */
+inline_speed ANPENDING* pending_pop(EV_P_ int pri) {
+  ANPENDING* p = pendings[pri] + --pendingcnt[pri];
+
+  if (!pendingcnt[pri])
+    pendingbits &= ~(1U << pri);
+
+  p->w->pending = 0;
+
+  return p;
+}
+
+#if EV_FEATURE_API
+/* counts one callback against the invoke budget, true once it is used up */
+inline_speed int invoke_spent(EV_P_ unsigned int* left, ev_tstamp until) {
+  if (ecb_expect_true((*left)-- && (until <= EV_TS_CONST(0.) || get_clock() < until)))
+    return 0;
+
+  invoke_leftover = 1;
+  return 1;
+}
+
+/* ev_invoke_pending with an invoke budget and/or priority weights: */
+/* weighted round-robin gives each pending priority up to its weight in callbacks */
+/* per round, and an exhausted budget leaves the rest for the next loop iteration */
+ecb_noinline ecb_cold static void invoke_pending_slow(EV_P) {
+  unsigned int left = invoke_budget ? invoke_budget : ~0U;
+  ev_tstamp until = invoke_timebudget > EV_TS_CONST(0.) ? get_clock() + invoke_timebudget : EV_TS_CONST(0.);
+
+  invoke_leftover = 0;
+
+  while (pendingbits) {
+    unsigned int quantum = 1; /* strict priorities: re-check after every callback */
+    int pri;
+
+    if (pri_weighted) {
+      /* next pending priority at or below the cursor, wrapping around */
+      unsigned int below = pendingbits & ((2U << pri_cursor) - 1U);
+
+      pri = ecb_ld32(below ? below : pendingbits);
+      pri_cursor = pri ? pri - 1 : NUMPRI - 1;
+      quantum = pri_weight[pri] ? pri_weight[pri] : 1;
+    }
+    else
+      pri = ecb_ld32(pendingbits);
+
+    do {
+      ANPENDING* p;
+
+      if (ecb_expect_false(invoke_spent(EV_A_ & left, until))) {
+        invoke_deferred += ev_pending_count(EV_A);
+        return;
+      }
+
+      p = pending_pop(EV_A_ pri);
+      EV_CB_INVOKE(p->w, p->events);
+      EV_FREQUENT_CHECK;
+    } while (--quantum && pendingcnt[pri]);
+  }
+}
+
+/* earliest deadline first, then higher priority, then the usual lifo order */
+inline_speed int edf_before(const ANEDF* a, const ANEDF* b) {
+  if (a->deadline != b->deadline)
+    return a->deadline < b->deadline;
+
+  if (a->pri != b->pri)
+    return a->pri > b->pri;
+
+  return a->idx > b->idx;
+}
+
+inline_speed void edf_upheap(ANEDF* heap, int k) {
+  ANEDF he = heap[k];
+
+  while (k) {
+    int p = (k - 1) >> 1;
+
+    if (!edf_before(&he, &heap[p]))
+      break;
+
+    heap[k] = heap[p];
+    k = p;
+  }
+
+  heap[k] = he;
+}
+
+inline_speed void edf_downheap(ANEDF* heap, int N, int k) {
+  ANEDF he = heap[k];
+
+  for (;;) {
+    int c = 2 * k + 1;
+
+    if (c >= N)
+      break;
+
+    if (c + 1 < N && edf_before(&heap[c + 1], &heap[c]))
+      ++c;
+
+    if (!edf_before(&heap[c], &he))
+      break;
+
+    heap[k] = heap[c];
+    k = c;
+  }
+
+  heap[k] = he;
+}
+
+/* squeeze out invoked and cleared entries, renumbering the watchers still pending */
+inline_size void edf_compact(EV_P) {
+  unsigned int bits = pendingbits;
+
+  while (bits) {
+    int pri = ecb_ld32(bits);
+    int i, j = 0;
+
+    bits &= ~(1U << pri);
+
+    for (i = 0; i < pendingcnt[pri]; ++i)
+      if (pendings[pri][i].w != (W)&pending_w) {
+        pendings[pri][j] = pendings[pri][i];
+        pendingdls[pri][j] = pendingdls[pri][i];
+        pendings[pri][j].w->pending = j + 1;
+        ++j;
+      }
+
+    pendingcnt[pri] = j;
+
+    if (!j)
+      pendingbits &= ~(1U << pri);
+  }
+}
+
+/* earliest-deadline-first dispatch: every round snapshots all pending watchers */
+/* into a heap, invokes them in deadline order and then drops them from pendings, */
+/* watchers queued by the callbacks are left for the next round. a callback that */
+/* invokes pendings itself renumbers them and reuses the heap, so the round ends */
+/* early and the next one starts from what the nested pass left behind */
+ecb_noinline ecb_cold static void invoke_pending_edf(EV_P) {
+  unsigned int left = invoke_budget ? invoke_budget : ~0U;
+  ev_tstamp until = invoke_timebudget > EV_TS_CONST(0.) ? get_clock() + invoke_timebudget : EV_TS_CONST(0.);
+
+  invoke_leftover = 0;
+
+  while (pendingbits) {
+    unsigned int bits = pendingbits;
+
+    edfcnt = 0;
+
+    while (bits) {
+      int pri = ecb_ld32(bits);
+      int i;
+
+      bits &= ~(1U << pri);
+      array_needsize(ANEDF, edfs, edfmax, edfcnt + pendingcnt[pri], array_needsize_noinit);
+
+      for (i = 0; i < pendingcnt[pri]; ++i) {
+        edfs[edfcnt].deadline = pendingdls[pri][i];
+        edfs[edfcnt].pri = pri;
+        edfs[edfcnt].idx = i;
+        edf_upheap(edfs, edfcnt++);
+      }
+    }
+
+    while (edfcnt) {
+      ANPENDING* p = pendings[edfs[0].pri] + edfs[0].idx;
+      W w = p->w;
+      unsigned int passes;
+
+      if (w != (W)&pending_w && ecb_expect_false(invoke_spent(EV_A_ & left, until))) {
+        edf_compact(EV_A);
+        invoke_deferred += ev_pending_count(EV_A);
+        return;
+      }
+
+      edfs[0] = edfs[--edfcnt];
+      edf_downheap(edfs, edfcnt, 0);
+
+      if (w == (W)&pending_w)
+        continue; /* cleared by ev_clear_pending */
+
+      p->w = (W)&pending_w;
+      w->pending = 0;
+      passes = invoke_passes;
+      EV_CB_INVOKE(w, p->events);
+      EV_FREQUENT_CHECK;
+
+      if (ecb_expect_false(passes != invoke_passes))
+        break;
+    }
+
+    edf_compact(EV_A);
+  }
+}
+#endif
+
+#if EV_DEFER_ENABLE
+/* make queued ev_defer calls in fifo order, including the ones they queue, */
+/* until the queue is empty or defer_limit calls were made */
+ecb_noinline static void defer_drain(EV_P) {
+  unsigned int left = defer_limit; /* 0 wraps around, which is as good as unlimited */
 
   do {
-    --pendingpri;
+    ev_defer* d = defer_head;
 
-    /* pendingpri possibly gets modified in the inner loop */
-    while (pendingcnt[pendingpri]) {
-      ANPENDING* p = pendings[pendingpri] + --pendingcnt[pendingpri];
+    if (!(defer_head = d->next))
+      defer_tail = &defer_head;
+
+    d->queued = 0;
+    d->cb(EV_A_ d);
+  } while (defer_head && --left);
+}
+
+#define DEFER_DRAIN                 \
+  do {                              \
+    if (ecb_expect_false(defer_head)) \
+      defer_drain(EV_A);            \
+  } while (0)
+#else
+#define DEFER_DRAIN \
+  do {              \
+  } while (0)
+#endif
+
+/* the default dispatch */
+inline_speed void invoke_plain(EV_P) {
+  do {
+    /* callbacks may queue higher priorities, so always take the highest pending one */
+    while (pendingbits) {
+      ANPENDING* p = pending_pop(EV_A_ ecb_ld32(pendingbits));
 
-      p->w->pending = 0;
       EV_CB_INVOKE(p->w, p->events);
       EV_FREQUENT_CHECK;
     }
-  } while (pendingpri);
+
+    DEFER_DRAIN;
+  } while (ecb_expect_false(pendingbits)); /* fed by deferred calls */
+}
+
+ecb_noinline void ev_invoke_pending(EV_P) {
+#if EV_FEATURE_API
+  ++invoke_passes;
+
+  if (ecb_expect_false(invoke_budget | pri_weighted | edf_active || invoke_timebudget > EV_TS_CONST(0.))) {
+    if (edf_active)
+      invoke_pending_edf(EV_A);
+    else
+      invoke_pending_slow(EV_A);
+
+    DEFER_DRAIN;
+    return;
+  }
+#endif
+
+  invoke_plain(EV_A);
+}
+
+/* prepare, check and idle watchers can be queued in bulk when nothing else is pending */
+#define queue_hooks_ok() !pendingbits
+
+/* and then invoked without the detour through invoke_cb when it is the default one */
+#if EV_FEATURE_API
+#define invoke_plain_ok()                                                                   \
+  (invoke_cb == ev_invoke_pending && !(invoke_budget | pri_weighted | edf_active) && \
+   invoke_timebudget <= EV_TS_CONST(0.))
+#else
+#define invoke_plain_ok() 1
+#endif
+
+/* the common priority of all watchers in ws, or -1 */
+inline_size int hooks_pri(W* ws, int cnt) {
+  int pri = ABSPRI(ws[0]);
+
+  while (--cnt)
+    if (ABSPRI(ws[cnt]) != pri)
+      return -1;
+
+  return pri;
+}
+
+/* queue_events for watchers sharing priority pri, none of them pending yet: */
+/* one size check and straight stores instead of an ev_feed_event per watcher */
+inline_speed void queue_hooks(EV_P_ W* ws, int cnt, int pri, int type) {
+  int n = pendingcnt[pri];
+  int i;
+
+  array_needsize(ANPENDING, pendings[pri], pendingmax[pri], n + cnt, array_needsize_noinit);
+
+  for (i = 0; i < cnt; ++i) {
+    pendings[pri][n + i].w = ws[i];
+    pendings[pri][n + i].events = type;
+    ws[i]->pending = n + i + 1;
+  }
+
+#if EV_FEATURE_API
+  if (ecb_expect_false(edf_tracked))
+    for (i = 0; i < cnt; ++i)
+      edf_track(EV_A_ pri, n + i, edf_active ? ev_rt_now + pri_deadline[pri] : EV_TS_CONST(0.));
+#endif
+
+  pendingcnt[pri] = n + cnt;
+  pendingbits |= 1U << pri;
 }
 
 #if EV_IDLE_ENABLE
@@ -624,11 +1171,9 @@ ecb_noinline void ev_invoke_pending(EV_P) {
 inline_size void idle_reify(EV_P) {
   if (ecb_expect_false(idleall)) {
     int pri;
+    int top = pendingbits ? ecb_ld32(pendingbits) : -1;
 
-    for (pri = NUMPRI; pri--;) {
-      if (pendingcnt[pri])
-        break;
-
+    for (pri = NUMPRI; --pri > top;) {
       if (idlecnt[pri]) {
         queue_events(EV_A_(W*) idles[pri], idlecnt[pri], EV_IDLE);
         break;
@@ -638,6 +1183,62 @@ inline_size void idle_reify(EV_P) {
 }
 #endif
 
+/* EV_INVOKE_PENDING after queue_hooks */
+inline_speed void hooks_invoke_pending(EV_P) {
+  if (ecb_expect_true(invoke_plain_ok())) {
+#if EV_FEATURE_API
+    ++invoke_passes;
+#endif
+    invoke_plain(EV_A);
+  }
+  else
+    EV_INVOKE_PENDING;
+}
+
+/* queue idle and check watchers and invoke everything pending, in bulk */
+/* if only idle and check watchers are due */
+inline_speed void hooks_invoke(EV_P) {
+#if EV_CHECK_ENABLE
+  if (queue_hooks_ok()) {
+    int cpri = checkcnt ? hooks_pri((W*)checks, checkcnt) : -1;
+
+    if (!checkcnt || cpri >= 0) {
+#if EV_IDLE_ENABLE
+      /* nothing is pending, so the highest priority with idle watchers is due */
+      if (ecb_expect_false(idleall)) {
+        int pri = NUMPRI;
+
+        while (!idlecnt[--pri])
+          ;
+
+        queue_hooks(EV_A_(W*) idles[pri], idlecnt[pri], pri, EV_IDLE);
+      }
+#endif
+
+      /* queued last, to be executed first */
+      if (ecb_expect_false(checkcnt))
+        queue_hooks(EV_A_(W*) checks, checkcnt, cpri, EV_CHECK);
+
+      hooks_invoke_pending(EV_A);
+      return;
+    }
+  }
+#endif
+
+#if EV_IDLE_ENABLE
+  /* queue idle watchers unless other events are pending */
+  idle_reify(EV_A);
+#endif
+
+#if EV_CHECK_ENABLE
+  /* queue check watchers, to be executed first */
+  if (ecb_expect_false(checkcnt))
+    queue_events(EV_A_(W*) checks, checkcnt, EV_CHECK);
+#endif
+
+  EV_INVOKE_PENDING;
+}
+
 /* make timers pending */
 inline_size void timers_reify(EV_P) {
   EV_FREQUENT_CHECK;
@@ -784,60 +1385,274 @@ inline_speed void time_update(EV_P_ ev_tstamp max_block) {
 
     mn_now = get_clock();
 
-    /* only fetch the realtime clock every 0.5*MIN_TIMEJUMP seconds */
-    /* interpolate in the meantime */
-    if (ecb_expect_true(mn_now - now_floor < EV_TS_CONST(MIN_TIMEJUMP * .5))) {
-      ev_rt_now = rtmn_diff + mn_now;
-      return;
+    /* only fetch the realtime clock every 0.5*MIN_TIMEJUMP seconds */
+    /* interpolate in the meantime */
+    if (ecb_expect_true(mn_now - now_floor < EV_TS_CONST(MIN_TIMEJUMP * .5))) {
+      ev_rt_now = rtmn_diff + mn_now;
+      return;
+    }
+
+    now_floor = mn_now;
+    ev_rt_now = ev_time();
+
+    /* loop a few times, before making important decisions.
+     * on the choice of "4": one iteration isn't enough,
+     * in case we get preempted during the calls to
+     * ev_time and get_clock. a second call is almost guaranteed
+     * to succeed in that case, though. and looping a few more times
+     * doesn't hurt either as we only do this on time-jumps or
+     * in the unlikely event of having been preempted here.
+     */
+    for (i = 4; --i;) {
+      ev_tstamp diff;
+      rtmn_diff = ev_rt_now - mn_now;
+
+      diff = odiff - rtmn_diff;
+
+      if (ecb_expect_true((diff < EV_TS_CONST(0.) ? -diff : diff) < EV_TS_CONST(MIN_TIMEJUMP)))
+        return; /* all is well */
+
+      ev_rt_now = ev_time();
+      mn_now = get_clock();
+      now_floor = mn_now;
+    }
+
+    /* no timer adjustment, as the monotonic clock doesn't jump */
+    /* timers_reschedule (EV_A_ rtmn_diff - odiff) */
+#if EV_PERIODIC_ENABLE
+    periodics_reschedule(EV_A);
+#endif
+  }
+  else
+#endif
+  {
+    ev_rt_now = ev_time();
+
+    if (ecb_expect_false(mn_now > ev_rt_now || ev_rt_now > mn_now + max_block + EV_TS_CONST(MIN_TIMEJUMP))) {
+      /* adjust timers. this is easy, as the offset is the same for all of them */
+      timers_reschedule(EV_A_ ev_rt_now - mn_now);
+#if EV_PERIODIC_ENABLE
+      periodics_reschedule(EV_A);
+#endif
+    }
+
+    mn_now = ev_rt_now;
+  }
+}
+
+#if EV_FEATURE_API
+/* poll without blocking until something is pending or the budget is used up, */
+/* returns true if events were found, otherwise shortens *waittime by the time spun */
+inline_size int busy_poll(EV_P_ ev_tstamp* waittime) {
+  ev_tstamp start = get_clock();
+  ev_tstamp spun;
+
+  do {
+    backend_poll(EV_A_ EV_TS_CONST(0.));
+
+    if (pendingbits)
+      return 1;
+
+    spun = get_clock() - start;
+  } while (spun < busy_polltime && spun < *waittime);
+
+  *waittime = *waittime > spun ? *waittime - spun : EV_TS_CONST(0.);
+
+  return 0;
+}
+#endif
+
+#if EV_FEATURE_API
+/* queue the hot watchers as if the kernel had reported them again */
+ecb_noinline static void hot_feed(EV_P) {
+  int i;
+
+  if (hotpolls >= HOT_POLL_EVERY)
+    hotpolls = 0;
+
+  for (i = 0; i < hotcnt; ++i)
+    if (ecb_expect_true(!ANFD_AT(hots[i].w->fd).reify))
+      ev_feed_event(EV_A_(W) hots[i].w, hots[i].events & hots[i].w->events);
+}
+#endif
+
+/* block for at most maxwait (less if timers are due or work is left over), */
+/* then queue the i/o events and expired timers */
+inline_speed void loop_wait(EV_P_ ev_tstamp maxwait) {
+  ev_tstamp waittime = 0.;
+  ev_tstamp sleeptime = 0.;
+
+  /* remember old timestamp for io_blocktime calculation */
+  ev_tstamp prev_mn_now = mn_now;
+
+  /* update time to cancel out callback processing overhead */
+  time_update(EV_A_ EV_TS_CONST(EV_TSTAMP_HUGE));
+
+  /* from now on, we want a pipe-wake-up */
+  pipe_write_wanted = 1;
+
+  ECB_MEMORY_FENCE; /* make sure pipe_write_wanted is visible before we check for potential skips */
+
+  /* an exhausted invoke budget left work behind, so only poll for new events */
+  if (ecb_expect_true(maxwait > EV_TS_CONST(0.) && !(idleall || !activecnt || pipe_write_skipped
+#if EV_FEATURE_API
+                        || invoke_leftover || hotcnt
+#endif
+#if EV_DEFER_ENABLE
+                        || defer_head || pendingbits /* over the limit, or fed by deferred calls */
+#endif
+                        ))) {
+    waittime = EV_TS_CONST(MAX_BLOCKTIME);
+
+#if EV_USE_TIMERFD
+    /* sleep a lot longer when we can reliably detect timejumps */
+    if (ecb_expect_true(timerfd >= 0))
+      waittime = EV_TS_CONST(MAX_BLOCKTIME2);
+#endif
+#if !EV_PERIODIC_ENABLE
+    /* without periodics but with monotonic clock there is no need */
+    /* for any time jump detection, so sleep longer */
+    if (ecb_expect_true(have_monotonic))
+      waittime = EV_TS_CONST(MAX_BLOCKTIME2);
+#endif
+
+    if (timercnt) {
+      ev_tstamp to = ANHE_at(timers[HEAP0]) - mn_now;
+      if (waittime > to)
+        waittime = to;
+    }
+
+#if EV_PERIODIC_ENABLE
+    if (periodiccnt) {
+      ev_tstamp to = ANHE_at(periodics[HEAP0]) - ev_rt_now;
+      if (waittime > to)
+        waittime = to;
     }
+#endif
 
-    now_floor = mn_now;
-    ev_rt_now = ev_time();
+    /* don't let timeouts decrease the waittime below timeout_blocktime */
+    if (ecb_expect_false(waittime < timeout_blocktime))
+      waittime = timeout_blocktime;
 
-    /* loop a few times, before making important decisions.
-     * on the choice of "4": one iteration isn't enough,
-     * in case we get preempted during the calls to
-     * ev_time and get_clock. a second call is almost guaranteed
-     * to succeed in that case, though. and looping a few more times
-     * doesn't hurt either as we only do this on time-jumps or
-     * in the unlikely event of having been preempted here.
+    if (ecb_expect_false(waittime > maxwait))
+      waittime = maxwait;
+
+    /* now there are two more special cases left, either we have
+     * already-expired timers, so we should not sleep, or we have timers
+     * that expire very soon, in which case we need to wait for a minimum
+     * amount of time for some event loop backends.
      */
-    for (i = 4; --i;) {
-      ev_tstamp diff;
-      rtmn_diff = ev_rt_now - mn_now;
+    if (ecb_expect_false(waittime < backend_mintime))
+      waittime = waittime <= EV_TS_CONST(0.) ? EV_TS_CONST(0.) : backend_mintime;
 
-      diff = odiff - rtmn_diff;
+    /* extra check because io_blocktime is commonly 0 */
+    if (ecb_expect_false(io_blocktime)) {
+      sleeptime = io_blocktime - (mn_now - prev_mn_now);
 
-      if (ecb_expect_true((diff < EV_TS_CONST(0.) ? -diff : diff) < EV_TS_CONST(MIN_TIMEJUMP)))
-        return; /* all is well */
+      if (sleeptime > waittime - backend_mintime)
+        sleeptime = waittime - backend_mintime;
 
-      ev_rt_now = ev_time();
-      mn_now = get_clock();
-      now_floor = mn_now;
+      if (ecb_expect_true(sleeptime > EV_TS_CONST(0.))) {
+        ev_sleep(sleeptime);
+        waittime -= sleeptime;
+      }
     }
+  }
 
-    /* no timer adjustment, as the monotonic clock doesn't jump */
-    /* timers_reschedule (EV_A_ rtmn_diff - odiff) */
-#if EV_PERIODIC_ENABLE
-    periodics_reschedule(EV_A);
+#if EV_FEATURE_API
+  ++loop_count;
 #endif
-  }
-  else
+  assert((loop_done = EVBREAK_RECURSE, 1)); /* assert for side effect */
+
+  if (ecb_expect_true(activeio)) {
+#if EV_FEATURE_API
+    if (ecb_expect_false(hotcnt) && ++hotpolls < HOT_POLL_EVERY)
+      ; /* hot fds are assumed to be ready, so don't ask the kernel every time */
+    else if (ecb_expect_false(busy_polltime > EV_TS_CONST(0.)) && waittime > EV_TS_CONST(0.) &&
+             busy_poll(EV_A_ & waittime))
+      ; /* the spin found events, don't block */
+    else
 #endif
-  {
-    ev_rt_now = ev_time();
+      backend_poll(EV_A_ waittime);
 
-    if (ecb_expect_false(mn_now > ev_rt_now || ev_rt_now > mn_now + max_block + EV_TS_CONST(MIN_TIMEJUMP))) {
-      /* adjust timers. this is easy, as the offset is the same for all of them */
-      timers_reschedule(EV_A_ ev_rt_now - mn_now);
+#if EV_FEATURE_API
+    if (ecb_expect_false(hotcnt))
+      hot_feed(EV_A);
+#endif
+  }
+  else if (ecb_expect_true(waittime > EV_TS_CONST(0.))) {
+    /* No kernel fds to poll, so just sleep in userspace until the next timeout. */
+    EV_RELEASE_CB;
+    ev_sleep(waittime);
+    EV_ACQUIRE_CB;
+  }
+
+  assert((loop_done = EVBREAK_CANCEL, 1)); /* assert for side effect */
+
+  pipe_write_wanted = 0; /* just an optimisation, no fence needed */
+
+  ECB_MEMORY_FENCE_ACQUIRE;
+  if (pipe_write_skipped) {
+    EV_ASSERT_MSG("libev: pipe_w not active, but pipe not written", ev_is_active(&pipe_w));
+    ev_feed_event(EV_A_ & pipe_w, EV_CUSTOM);
+  }
+
+  /* update ev_rt_now, do magic */
+  time_update(EV_A_ waittime + sleeptime);
+
+  /* queue pending timers and reschedule them */
+  timers_reify(EV_A); /* relative timers called last */
 #if EV_PERIODIC_ENABLE
-      periodics_reschedule(EV_A);
+  periodics_reify(EV_A); /* absolute timers called first */
+#endif
+}
+
+#if EV_FEATURE_API
+int ev_poll_ready(EV_P_ ev_ready* out, int max, ev_tstamp timeout) {
+  int n = 0;
+
+  /* hand out what is already pending before polling for more */
+  if (!pendingbits) {
+#ifndef _WIN32
+    if (ecb_expect_false(curpid))
+      if (ecb_expect_false(getpid() != curpid)) {
+        curpid = getpid();
+        postfork = 1;
+      }
+#endif
+
+    if (ecb_expect_false(postfork)) {
+#if EV_FORK_ENABLE
+      if (forkcnt)
+        queue_events(EV_A_(W*) forks, forkcnt, EV_FORK);
 #endif
+      loop_fork(EV_A);
     }
 
-    mn_now = ev_rt_now;
+    fd_reify(EV_A);
+    loop_wait(EV_A_ timeout);
   }
+
+  /* in invocation order, watchers with callbacks (including libev's own) get invoked */
+  while (pendingbits && n < max) {
+    ANPENDING* p = pending_pop(EV_A_ ecb_ld32(pendingbits));
+
+    if (ecb_expect_true(!ev_cb(p->w))) {
+      out[n].w = (ev_watcher*)p->w;
+      out[n].revents = p->events;
+      ++n;
+    }
+    else {
+      EV_CB_INVOKE(p->w, p->events);
+      EV_FREQUENT_CHECK;
+    }
+  }
+
+  DEFER_DRAIN;
+
+  return n;
 }
+#endif
 
 int ev_run(EV_P_ int flags) {
 #if EV_FEATURE_API
@@ -875,8 +1690,16 @@ int ev_run(EV_P_ int flags) {
 #if EV_PREPARE_ENABLE
     /* queue prepare watchers (and execute them) */
     if (ecb_expect_false(preparecnt)) {
-      queue_events(EV_A_(W*) prepares, preparecnt, EV_PREPARE);
-      EV_INVOKE_PENDING;
+      int pri = queue_hooks_ok() ? hooks_pri((W*)prepares, preparecnt) : -1;
+
+      if (pri >= 0) {
+        queue_hooks(EV_A_(W*) prepares, preparecnt, pri, EV_PREPARE);
+        hooks_invoke_pending(EV_A);
+      }
+      else {
+        queue_events(EV_A_(W*) prepares, preparecnt, EV_PREPARE);
+        EV_INVOKE_PENDING;
+      }
     }
 #endif
 
@@ -887,6 +1710,14 @@ int ev_run(EV_P_ int flags) {
     if (ecb_expect_false(postfork))
       loop_fork(EV_A);
 
+#if EV_DEFER_ENABLE
+    /* a custom invoke callback might not have made the deferred calls */
+    if (ecb_expect_false(defer_head)) {
+      defer_drain(EV_A);
+      EV_INVOKE_PENDING;
+    }
+#endif
+
     /* update fd-related kernel structures */
     fd_reify(EV_A);
 
@@ -903,135 +1734,16 @@ int ev_run(EV_P_ int flags) {
       ++loop_count;
 #endif
 
-      idle_reify(EV_A);
-
-#if EV_CHECK_ENABLE
-      if (ecb_expect_false(checkcnt))
-        queue_events(EV_A_(W*) checks, checkcnt, EV_CHECK);
-#endif
-
-      EV_INVOKE_PENDING;
+      hooks_invoke(EV_A);
       continue;
     }
 #endif
 
-    /* calculate blocking time */
-    {
-      ev_tstamp waittime = 0.;
-      ev_tstamp sleeptime = 0.;
-
-      /* remember old timestamp for io_blocktime calculation */
-      ev_tstamp prev_mn_now = mn_now;
-
-      /* update time to cancel out callback processing overhead */
-      time_update(EV_A_ EV_TS_CONST(EV_TSTAMP_HUGE));
-
-      /* from now on, we want a pipe-wake-up */
-      pipe_write_wanted = 1;
-
-      ECB_MEMORY_FENCE; /* make sure pipe_write_wanted is visible before we check for potential skips */
-
-      if (ecb_expect_true(!(flags & EVRUN_NOWAIT || idleall || !activecnt || pipe_write_skipped))) {
-        waittime = EV_TS_CONST(MAX_BLOCKTIME);
-
-#if EV_USE_TIMERFD
-        /* sleep a lot longer when we can reliably detect timejumps */
-        if (ecb_expect_true(timerfd >= 0))
-          waittime = EV_TS_CONST(MAX_BLOCKTIME2);
-#endif
-#if !EV_PERIODIC_ENABLE
-        /* without periodics but with monotonic clock there is no need */
-        /* for any time jump detection, so sleep longer */
-        if (ecb_expect_true(have_monotonic))
-          waittime = EV_TS_CONST(MAX_BLOCKTIME2);
-#endif
-
-        if (timercnt) {
-          ev_tstamp to = ANHE_at(timers[HEAP0]) - mn_now;
-          if (waittime > to)
-            waittime = to;
-        }
-
-#if EV_PERIODIC_ENABLE
-        if (periodiccnt) {
-          ev_tstamp to = ANHE_at(periodics[HEAP0]) - ev_rt_now;
-          if (waittime > to)
-            waittime = to;
-        }
-#endif
-
-        /* don't let timeouts decrease the waittime below timeout_blocktime */
-        if (ecb_expect_false(waittime < timeout_blocktime))
-          waittime = timeout_blocktime;
-
-        /* now there are two more special cases left, either we have
-         * already-expired timers, so we should not sleep, or we have timers
-         * that expire very soon, in which case we need to wait for a minimum
-         * amount of time for some event loop backends.
-         */
-        if (ecb_expect_false(waittime < backend_mintime))
-          waittime = waittime <= EV_TS_CONST(0.) ? EV_TS_CONST(0.) : backend_mintime;
-
-        /* extra check because io_blocktime is commonly 0 */
-        if (ecb_expect_false(io_blocktime)) {
-          sleeptime = io_blocktime - (mn_now - prev_mn_now);
-
-          if (sleeptime > waittime - backend_mintime)
-            sleeptime = waittime - backend_mintime;
-
-          if (ecb_expect_true(sleeptime > EV_TS_CONST(0.))) {
-            ev_sleep(sleeptime);
-            waittime -= sleeptime;
-          }
-        }
-      }
-
-#if EV_FEATURE_API
-      ++loop_count;
-#endif
-      assert((loop_done = EVBREAK_RECURSE, 1)); /* assert for side effect */
-
-      if (ecb_expect_true(activeio))
-        backend_poll(EV_A_ waittime);
-      else if (ecb_expect_true(waittime > EV_TS_CONST(0.))) {
-        /* No kernel fds to poll, so just sleep in userspace until the next timeout. */
-        EV_RELEASE_CB;
-        ev_sleep(waittime);
-        EV_ACQUIRE_CB;
-      }
-
-      assert((loop_done = EVBREAK_CANCEL, 1)); /* assert for side effect */
-
-      pipe_write_wanted = 0; /* just an optimisation, no fence needed */
-
-      ECB_MEMORY_FENCE_ACQUIRE;
-      if (pipe_write_skipped) {
-        EV_ASSERT_MSG("libev: pipe_w not active, but pipe not written", ev_is_active(&pipe_w));
-        ev_feed_event(EV_A_ & pipe_w, EV_CUSTOM);
-      }
-
-      /* update ev_rt_now, do magic */
-      time_update(EV_A_ waittime + sleeptime);
-    }
-
-    /* queue pending timers and reschedule them */
-    timers_reify(EV_A); /* relative timers called last */
-#if EV_PERIODIC_ENABLE
-    periodics_reify(EV_A); /* absolute timers called first */
-#endif
-
-#if EV_IDLE_ENABLE
-    /* queue idle watchers unless other events are pending */
-    idle_reify(EV_A);
-#endif
-
-#if EV_CHECK_ENABLE
-    /* queue check watchers, to be executed first */
-    if (ecb_expect_false(checkcnt))
-      queue_events(EV_A_(W*) checks, checkcnt, EV_CHECK);
-#endif
+    /* wait for events and queue them along with expired timers */
+    loop_wait(EV_A_ flags & EVRUN_NOWAIT ? EV_TS_CONST(0.) : EV_TS_CONST(EV_TSTAMP_HUGE));
 
-    EV_INVOKE_PENDING;
+    /* idle and check watchers, checks executed first */
+    hooks_invoke(EV_A);
   } while (ecb_expect_true(activecnt && !loop_done && !(flags & (EVRUN_ONCE | EVRUN_NOWAIT))));
 
   if (loop_done == EVBREAK_ONE)
@@ -1146,10 +1858,10 @@ ecb_noinline void ev_io_start(EV_P_ ev_io* w) EV_NOEXCEPT {
   /* Some callers built against mismatched headers accidentally pass in extra bits.
      Clamp to the valid EV_READ/EV_WRITE mask instead of aborting to stay
      compatible with consumers such as picom that mix libev builds. */
-  if (ecb_expect_false(w->events & ~(EV_READ | EV_WRITE)))
-    w->events &= EV_READ | EV_WRITE;
+  if (ecb_expect_false(w->events & ~(EV_READ | EV_WRITE | EV_SPECULATIVE)))
+    w->events &= EV_READ | EV_WRITE | EV_SPECULATIVE;
 
-  int needs_fdset = w->fd & EV__IOFDSET;
+  int needs_fdset = w->fd & EV__IOFDSET ? EV_ANFD_IOFDSET : 0;
   int fd = ev_io_fd(w);
 
   EV_ASSERT_MSG("libev: ev_io_start called with negative fd", fd >= 0);
@@ -1163,8 +1875,14 @@ ecb_noinline void ev_io_start(EV_P_ ev_io* w) EV_NOEXCEPT {
 
   ev_start(EV_A_(W) w, 1);
   ++activeio;
-  array_needsize(ANFD, anfds, anfdmax, fd + 1, array_needsize_zerofill);
-  wlist_add(&anfds[fd].head, (WL)w);
+  fd_need(EV_A_ fd);
+  fd_mark(EV_A_ fd);
+  ANFDCNT_AT(fd).readers += !!(w->events & EV_READ);
+  ANFDCNT_AT(fd).writers += !!(w->events & EV_WRITE);
+#if EV_USE_ANFDX
+  array_needsize(ANFDX, anfdxs, anfdxmax, fd + 1, array_needsize_zerofill);
+#endif
+  wlist_add(&ANFD_AT(fd).head, (WL)w);
 
   /* common bug, apparently */
   EV_ASSERT_MSG("libev: ev_io_start called with corrupted watcher", ((WL)w)->next != (WL)w);
@@ -1174,7 +1892,8 @@ ecb_noinline void ev_io_start(EV_P_ ev_io* w) EV_NOEXCEPT {
   EV_FREQUENT_CHECK;
 }
 
-ecb_noinline void ev_io_stop(EV_P_ ev_io* w) EV_NOEXCEPT {
+/* ev_io_stop without the fd validity check, as fd_kill stops watchers of fds that are gone */
+inline_speed void io_stop(EV_P_ ev_io* w) {
   clear_pending(EV_A_(W) w);
   if (ecb_expect_false(!ev_is_active(w)))
     return;
@@ -1182,12 +1901,16 @@ ecb_noinline void ev_io_stop(EV_P_ ev_io* w) EV_NOEXCEPT {
   EV_ASSERT_MSG("libev: ev_io_stop called with illegal fd (must stay constant after start!)",
                 w->fd >= 0 && w->fd < anfdmax);
 
-#if EV_VERIFY >= 2
-  EV_ASSERT_MSG("libev: ev_io_stop called on watcher with invalid fd", fd_valid(w->fd));
-#endif
   EV_FREQUENT_CHECK;
 
-  wlist_del(&anfds[w->fd].head, (WL)w);
+#if EV_FEATURE_API
+  if (ecb_expect_false(w->events & EV__IOHOT))
+    hot_del(EV_A_ w);
+#endif
+
+  wlist_del(&ANFD_AT(w->fd).head, (WL)w);
+  ANFDCNT_AT(w->fd).readers -= !!(w->events & EV_READ);
+  ANFDCNT_AT(w->fd).writers -= !!(w->events & EV_WRITE);
   --activeio;
   ev_stop(EV_A_(W) w);
 
@@ -1196,6 +1919,97 @@ ecb_noinline void ev_io_stop(EV_P_ ev_io* w) EV_NOEXCEPT {
   EV_FREQUENT_CHECK;
 }
 
+ecb_noinline void ev_io_stop(EV_P_ ev_io* w) EV_NOEXCEPT {
+#if EV_VERIFY >= 2
+  EV_ASSERT_MSG("libev: ev_io_stop called on watcher with invalid fd", !ev_is_active(w) || fd_valid(w->fd));
+#endif
+
+  io_stop(EV_A_ w);
+}
+
+#if EV_FEATURE_API
+void ev_io_eagain(EV_P_ ev_io* w) EV_NOEXCEPT {
+  if (w->events & EV__IOHOT)
+    hot_del(EV_A_ w);
+}
+#endif
+
+#if EV_MULTIPLICITY
+#if EV_USE_IO_MIGRATE
+/* only the target loop can set up its wakeup pipe, and tells other threads when it did */
+inline_size int migrate_wakeable(EV_P) {
+  return ev_atomic_load(&migrate_ready);
+}
+
+/* hand a chain of stopped watchers to this loop, called from another thread */
+inline_size void migrate_push(EV_P_ ev_io* first, ev_io* last) {
+  ev_io* head = migrate_in;
+
+  do
+    ((WL)last)->next = (WL)head;
+  while (!ev_atomic_cas(&migrate_in, &head, first));
+
+  evpipe_write(EV_A_ & migrate_pending);
+}
+#endif
+
+int ev_io_migrate(EV_P_ int fd, struct ev_loop* other) EV_NOEXCEPT {
+#if EV_USE_IO_MIGRATE
+  ev_io* first = 0;
+  ev_io* last = 0;
+  int cnt = 0;
+
+  if (fd < 0 || fd >= anfdmax || !ANFD_AT(fd).head || other == EV_A)
+    return 0;
+
+  if (!migrate_wakeable(other))
+    return -1;
+
+  EV_FREQUENT_CHECK;
+
+  while (ANFD_AT(fd).head) {
+    ev_io* w = (ev_io*)ANFD_AT(fd).head;
+    int revents = w->pending ? pendings[ABSPRI(w)][w->pending - 1].events & (EV_READ | EV_WRITE) : 0;
+
+    ev_io_stop(EV_A_ w);
+
+    w->events |= revents << EV__IOMIGRATED_SHIFT;
+    ((WL)w)->next = 0;
+
+    if (last)
+      ((WL)last)->next = (WL)w;
+    else
+      first = w;
+
+    last = w;
+    ++cnt;
+  }
+
+  /* the fd belongs to the other loop now, do not wait for fd_reify. epoll_modify */
+  /* ignores removals, so epoll needs an explicit EPOLL_CTL_DEL */
+  if (ANFD_AT(fd).events) {
+    backend_modify(EV_A_ fd, ANFD_AT(fd).events, 0);
+    ANFD_AT(fd).events = 0;
+  }
+
+#if EV_USE_EPOLL
+  if (backend == EVBACKEND_EPOLL)
+    epoll_forget(EV_A_ fd);
+#endif
+
+  migrate_push(other, first, last);
+
+  EV_FREQUENT_CHECK;
+
+  return cnt;
+#else
+  (void)fd;
+  (void)other;
+  return -1;
+#endif
+}
+#endif
+
 ecb_noinline void ev_timer_start(EV_P_ ev_timer* w) EV_NOEXCEPT {
   if (ecb_expect_false(ev_is_active(w)))
     return;
@@ -1208,7 +2022,7 @@ ecb_noinline void ev_timer_start(EV_P_ ev_timer* w) EV_NOEXCEPT {
 
   ++timercnt;
   ev_start(EV_A_(W) w, timercnt + HEAP0 - 1);
-  array_needsize(ANHE, timers, timermax, ev_active(w) + 1, array_needsize_noinit);
+  array_needsize_huge(ANHE, timers, timermax, ev_active(w) + 1, array_needsize_noinit);
   ANHE_w(timers[ev_active(w)]) = (WT)w;
   ANHE_at_cache(timers[ev_active(w)]);
   upheap(timers, ev_active(w));
@@ -1378,14 +2192,18 @@ ecb_noinline void ev_signal_start(EV_P_ ev_signal* w) EV_NOEXCEPT {
 
 #if EV_USE_SIGNALFD
   if (sigfd == -2) {
-    sigfd = signalfd(-1, &sigfd_set, SFD_NONBLOCK | SFD_CLOEXEC);
+    sigset_t ss;
+
+    sigemptyset(&ss);
+    sigfd = signalfd(-1, &ss, SFD_NONBLOCK | SFD_CLOEXEC);
     if (sigfd < 0 && errno == EINVAL)
-      sigfd = signalfd(-1, &sigfd_set, 0); /* retry without flags */
+      sigfd = signalfd(-1, &ss, 0); /* retry without flags */
 
     if (sigfd >= 0) {
       fd_intern(sigfd); /* doing it twice will not hurt */
 
-      sigemptyset(&sigfd_set);
+      sigfd_set = (sigset_t*)loop_malloc(sizeof(sigset_t));
+      sigemptyset(sigfd_set);
 
       ev_io_init(&sigfd_w, sigfdcb, sigfd, EV_READ);
       ev_set_priority(&sigfd_w, EV_MAXPRI);
@@ -1396,10 +2214,10 @@ ecb_noinline void ev_signal_start(EV_P_ ev_signal* w) EV_NOEXCEPT {
 
   if (sigfd >= 0) {
     if (!signals[w->signum - 1].head) {
-      sigaddset(&sigfd_set, w->signum);
-      sigprocmask(SIG_BLOCK, &sigfd_set, 0);
+      sigaddset(sigfd_set, w->signum);
+      sigprocmask(SIG_BLOCK, sigfd_set, 0);
 
-      signalfd(sigfd, &sigfd_set, 0);
+      signalfd(sigfd, sigfd_set, 0);
     }
   }
 #endif
@@ -1460,9 +2278,9 @@ ecb_noinline void ev_signal_stop(EV_P_ ev_signal* w) EV_NOEXCEPT {
 
       sigemptyset(&ss);
       sigaddset(&ss, w->signum);
-      sigdelset(&sigfd_set, w->signum);
+      sigdelset(sigfd_set, w->signum);
 
-      signalfd(sigfd, &sigfd_set, 0);
+      signalfd(sigfd, sigfd_set, 0);
       sigprocmask(SIG_UNBLOCK, &ss, 0);
     }
     else
@@ -1678,6 +2496,8 @@ inline_size void infy_init(EV_P) {
 
   if (fs_fd >= 0) {
     fd_intern(fs_fd);
+    fs_hash = (ANFS*)loop_malloc(sizeof(ANFS) * (EV_INOTIFY_HASHSIZE));
+    memset(fs_hash, 0, sizeof(ANFS) * (EV_INOTIFY_HASHSIZE));
     ev_io_init(&fs_w, infy_cb, fs_fd, EV_READ);
     ev_set_priority(&fs_w, EV_MAXPRI);
     ev_io_start(EV_A_ & fs_w);
@@ -2126,6 +2946,13 @@ void ev_async_start(EV_P_ ev_async* w) EV_NOEXCEPT {
 
   evpipe_init(EV_A);
 
+#if EV_USE_ASYNC_MAP
+  if (ecb_expect_false(!async_map)) {
+    async_map = (uint64_t*)loop_malloc(sizeof(uint64_t) * EV_ASYNC_MAPWORDS);
+    memset(async_map, 0, sizeof(uint64_t) * EV_ASYNC_MAPWORDS);
+  }
+#endif
+
   EV_FREQUENT_CHECK;
 
   ev_start(EV_A_(W) w, ++asynccnt);
@@ -2147,6 +2974,14 @@ void ev_async_stop(EV_P_ ev_async* w) EV_NOEXCEPT {
 
     asyncs[active - 1] = asyncs[--asynccnt];
     ev_active(asyncs[active - 1]) = active;
+
+#if EV_USE_ASYNC_MAP
+    /* a concurrent sender might have marked the old index of the moved */
+    /* watcher, so re-send it - the fence pairs with the one in ev_async_send */
+    ECB_MEMORY_FENCE;
+    if (asyncs[active - 1]->sent)
+      ev_async_send(EV_A_ asyncs[active - 1]);
+#endif
   }
 
   ev_stop(EV_A_(W) w);
@@ -2156,45 +2991,132 @@ void ev_async_stop(EV_P_ ev_async* w) EV_NOEXCEPT {
 
 void ev_async_send(EV_P_ ev_async* w) EV_NOEXCEPT {
   w->sent = 1;
+#if EV_USE_ASYNC_MAP
+  ECB_MEMORY_FENCE; /* publish sent before reading the index, see ev_async_stop */
+  async_map_set(EV_A_ ev_active(w) - 1);
+#endif
   evpipe_write(EV_A_ & async_pending);
 }
 #endif
 
+#if EV_WORK_ENABLE
+void ev_work_start(EV_P_ ev_work* w) EV_NOEXCEPT {
+  if (ecb_expect_false(ev_is_active(w)))
+    return;
+
+  w->origin = EV_A;
+  w->cancelled = 0;
+
+  /* completions arrive through the wakeup pipe */
+  evpipe_init(EV_A);
+
+  EV_FREQUENT_CHECK;
+
+  ev_start(EV_A_(W) w, 1);
+  work_submit(w);
+
+  EV_FREQUENT_CHECK;
+}
+
+void ev_work_stop(EV_P_ ev_work* w) EV_NOEXCEPT {
+  clear_pending(EV_A_(W) w);
+  if (ecb_expect_false(!ev_is_active(w)))
+    return;
+
+  /* the pool still owns it, work_drain deactivates it silently */
+  w->cancelled = 1;
+}
+#endif
+
+#if EV_DEFER_ENABLE
+void ev_defer_call(EV_P_ ev_defer* d) EV_NOEXCEPT {
+  if (ecb_expect_false(d->queued))
+    return;
+
+  d->queued = 1;
+  d->next = 0;
+  *defer_tail = d;
+  defer_tail = &d->next;
+}
+
+void ev_defer_cancel(EV_P_ ev_defer* d) EV_NOEXCEPT {
+  ev_defer** dp;
+
+  if (!d->queued)
+    return;
+
+  for (dp = &defer_head; *dp != d; dp = &(*dp)->next)
+    ;
+
+  if (!(*dp = d->next))
+    defer_tail = dp;
+
+  d->queued = 0;
+}
+
+void ev_set_defer_limit(EV_P_ unsigned int calls) EV_NOEXCEPT {
+  defer_limit = calls;
+}
+#endif
+
 /*****************************************************************************/
 
-struct ev_once {
-  ev_io io;
-  ev_timer to;
-  void (*cb)(int revents, void* arg);
-  void* arg;
+/* ev_once blocks come in slabs and go back onto a per-loop freelist */
+#define ONCE_SLAB 64
+
+struct once_slab {
+  struct once_slab* next;
+  ev_once_storage once[ONCE_SLAB];
 };
 
-static void once_cb(EV_P_ struct ev_once* once, int revents) {
+ecb_noinline ecb_cold static ev_once_storage* once_refill(EV_P) {
+  struct once_slab* slab = (struct once_slab*)loop_malloc(sizeof(struct once_slab));
+  int i;
+
+  slab->next = (struct once_slab*)once_slabs;
+  once_slabs = slab;
+
+  for (i = ONCE_SLAB; i--;) {
+    slab->once[i].arg = once_free;
+    once_free = &slab->once[i];
+  }
+
+  return once_free;
+}
+
+static void once_cb(EV_P_ ev_once_storage* once, int revents) {
   void (*cb)(int revents, void* arg) = once->cb;
   void* arg = once->arg;
 
   ev_io_stop(EV_A_ & once->io);
   ev_timer_stop(EV_A_ & once->to);
-  ev_free(once);
+
+  if (once->pooled) {
+    once->arg = once_free;
+    once_free = once;
+  }
 
   cb(revents, arg);
 }
 
 static void once_cb_io(EV_P_ ev_io* w, int revents) {
-  struct ev_once* once = (struct ev_once*)(((char*)w) - offsetof(struct ev_once, io));
+  ev_once_storage* once = (ev_once_storage*)(((char*)w) - offsetof(ev_once_storage, io));
 
   once_cb(EV_A_ once, revents | ev_clear_pending(EV_A_ & once->to));
 }
 
 static void once_cb_to(EV_P_ ev_timer* w, int revents) {
-  struct ev_once* once = (struct ev_once*)(((char*)w) - offsetof(struct ev_once, to));
+  ev_once_storage* once = (ev_once_storage*)(((char*)w) - offsetof(ev_once_storage, to));
 
   once_cb(EV_A_ once, revents | ev_clear_pending(EV_A_ & once->io));
 }
 
-void ev_once(EV_P_ int fd, int events, ev_tstamp timeout, void (*cb)(int revents, void* arg), void* arg) EV_NOEXCEPT {
-  struct ev_once* once = (struct ev_once*)ev_malloc(sizeof(struct ev_once));
-
+inline_speed void once_start(EV_P_ ev_once_storage* once,
+                             int fd,
+                             int events,
+                             ev_tstamp timeout,
+                             void (*cb)(int revents, void* arg),
+                             void* arg) {
   once->cb = cb;
   once->arg = arg;
 
@@ -2211,6 +3133,27 @@ void ev_once(EV_P_ int fd, int events, ev_tstamp timeout, void (*cb)(int revents
   }
 }
 
+void ev_once(EV_P_ int fd, int events, ev_tstamp timeout, void (*cb)(int revents, void* arg), void* arg) EV_NOEXCEPT {
+  ev_once_storage* once = once_free;
+
+  if (ecb_expect_false(!once))
+    once = once_refill(EV_A);
+
+  once_free = (ev_once_storage*)once->arg;
+  once->pooled = 1;
+  once_start(EV_A_ once, fd, events, timeout, cb, arg);
+}
+
+void ev_once_start(EV_P_ ev_once_storage* once,
+                   int fd,
+                   int events,
+                   ev_tstamp timeout,
+                   void (*cb)(int revents, void* arg),
+                   void* arg) EV_NOEXCEPT {
+  once->pooled = 0;
+  once_start(EV_A_ once, fd, events, timeout, cb, arg);
+}
+
 /*****************************************************************************/
 
 #if EV_WALK_ENABLE
@@ -2219,8 +3162,8 @@ ecb_cold void ev_walk(EV_P_ int types, void (*cb)(EV_P_ int type, void* w)) EV_N
   ev_watcher_list *wl, *wn;
 
   if (types & (EV_IO | EV_EMBED))
-    for (i = 0; i < anfdmax; ++i)
-      for (wl = anfds[i].head; wl;) {
+    for (i = fd_next(EV_A_ 0); i >= 0; i = fd_next(EV_A_ i + 1))
+      for (wl = ANFD_AT(i).head; wl;) {
         wn = wl->next;
 
 #if EV_EMBED_ENABLE
@@ -2256,7 +3199,7 @@ ecb_cold void ev_walk(EV_P_ int types, void (*cb)(EV_P_ int type, void* w)) EV_N
         cb(EV_A_ EV_TIMER, ANHE_w(timers[i]));
 
 #if EV_STAT_ENABLE && EV_USE_INOTIFY
-  if (types & EV_STAT)
+  if ((types & EV_STAT) && fs_hash)
     for (i = 0; i < (EV_INOTIFY_HASHSIZE); ++i)
       for (wl = fs_hash[i].head; wl; wl = wl->next) {
         ev_stat* w = (ev_stat*)wl;
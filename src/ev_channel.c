@@ -0,0 +1,182 @@
+/* src/ev_channel.c
+ * single-producer/single-consumer message rings between loops, built on ev_async
+ */
+
+#if EV_CHANNEL_ENABLE
+
+static void channel_reader_cb(EV_P_ ev_async* w, int revents) {
+  ev_channel* c = (ev_channel*)(((char*)w) - offsetof(ev_channel, reader));
+
+  (void)revents;
+
+  c->read_cb(EV_A_ c, EV_READ);
+}
+
+static void channel_writer_cb(EV_P_ ev_async* w, int revents) {
+  ev_channel* c = (ev_channel*)(((char*)w) - offsetof(ev_channel, writer));
+
+  (void)revents;
+
+  if (c->write_cb)
+    c->write_cb(EV_A_ c, EV_WRITE);
+}
+
+void ev_channel_init(ev_channel* c,
+                     void* buf,
+                     unsigned int size,
+                     unsigned int capacity,
+                     void (*read_cb)(EV_P_ ev_channel* c, int revents),
+                     void (*write_cb)(EV_P_ ev_channel* c, int revents)) EV_NOEXCEPT {
+  EV_ASSERT_MSG("libev: ev_channel capacity must be a non-zero power of two",
+                capacity && !(capacity & (capacity - 1)));
+
+  memset(c, 0, sizeof(*c));
+
+  ev_async_init(&c->reader, channel_reader_cb);
+  ev_async_init(&c->writer, channel_writer_cb);
+
+  c->read_cb = read_cb;
+  c->write_cb = write_cb;
+  c->buf = (char*)buf;
+  c->size = size;
+  c->mask = capacity - 1;
+}
+
+void ev_channel_reader_start(EV_P_ ev_channel* c) EV_NOEXCEPT {
+  if (ecb_expect_false(ev_is_active(&c->reader)))
+    return;
+
+  c->read_loop = EV_A;
+  ev_async_start(EV_A_ & c->reader);
+
+  ECB_MEMORY_FENCE; /* publish read_loop before looking at tail, pairs with ev_channel_write */
+
+  /* messages written while no reader was attached did not wake anybody */
+  if (c->tail != c->head)
+    ev_async_send(EV_A_ & c->reader);
+}
+
+void ev_channel_reader_stop(EV_P_ ev_channel* c) EV_NOEXCEPT {
+  ev_async_stop(EV_A_ & c->reader);
+  c->read_loop = 0;
+  ECB_MEMORY_FENCE_RELEASE;
+}
+
+void ev_channel_writer_start(EV_P_ ev_channel* c) EV_NOEXCEPT {
+  if (ecb_expect_false(ev_is_active(&c->writer)))
+    return;
+
+  c->write_loop = EV_A;
+  ev_async_start(EV_A_ & c->writer);
+  ECB_MEMORY_FENCE_RELEASE;
+}
+
+void ev_channel_writer_stop(EV_P_ ev_channel* c) EV_NOEXCEPT {
+  ev_async_stop(EV_A_ & c->writer);
+  c->write_loop = 0;
+  ECB_MEMORY_FENCE_RELEASE;
+}
+
+/* copy n messages into or out of the ring, starting at position pos, handling wrap-around */
+inline_speed void channel_copy(ev_channel* c, unsigned int pos, char* msgs, unsigned int n, int out) {
+  unsigned int idx = pos & c->mask;
+  unsigned int first = c->mask + 1 - idx;
+
+  if (first > n)
+    first = n;
+
+  if (out) {
+    memcpy(msgs, c->buf + (size_t)idx * c->size, (size_t)first * c->size);
+    memcpy(msgs + (size_t)first * c->size, c->buf, (size_t)(n - first) * c->size);
+  }
+  else {
+    memcpy(c->buf + (size_t)idx * c->size, msgs, (size_t)first * c->size);
+    memcpy(c->buf, msgs + (size_t)first * c->size, (size_t)(n - first) * c->size);
+  }
+}
+
+unsigned int ev_channel_write(ev_channel* c, const void* msgs, unsigned int n) EV_NOEXCEPT {
+  unsigned int tail = c->tail;
+  unsigned int room = c->mask + 1 - (tail - c->head_cache);
+
+  /* only look at the consumer's cache line when our cached view is exhausted */
+  if (room < n) {
+    c->head_cache = c->head;
+    ECB_MEMORY_FENCE_ACQUIRE;
+    room = c->mask + 1 - (tail - c->head_cache);
+
+    if (room < n) {
+      /* ask the consumer for a wakeup, then re-check to close the race with it */
+      c->want_space = 1;
+      ECB_MEMORY_FENCE;
+      c->head_cache = c->head;
+      room = c->mask + 1 - (tail - c->head_cache);
+
+      if (room >= n)
+        c->want_space = 0;
+      else
+        n = room;
+    }
+  }
+
+  if (ecb_expect_false(!n))
+    return 0;
+
+  channel_copy(c, tail, (char*)msgs, n, 0);
+
+  ECB_MEMORY_FENCE_RELEASE; /* messages must be visible before the new tail */
+  c->tail = tail + n;
+  ECB_MEMORY_FENCE; /* publish tail before checking whether the consumer ran dry */
+
+  /* only wake up the reader on an empty -> non-empty transition */
+  if (c->head == tail) {
+    struct ev_loop* rloop = c->read_loop;
+
+    if (rloop)
+      ev_async_send(rloop, &c->reader);
+  }
+
+  return n;
+}
+
+unsigned int ev_channel_read(ev_channel* c, void* msgs, unsigned int max) EV_NOEXCEPT {
+  unsigned int head = c->head;
+  unsigned int avail = c->tail_cache - head;
+
+  if (avail < max) {
+    c->tail_cache = c->tail;
+    ECB_MEMORY_FENCE_ACQUIRE; /* read the messages only after the tail */
+    avail = c->tail_cache - head;
+  }
+
+  if (avail > max)
+    avail = max;
+
+  if (ecb_expect_false(!avail))
+    return 0;
+
+  channel_copy(c, head, (char*)msgs, avail, 1);
+
+  ECB_MEMORY_FENCE; /* finish reading the slots before handing them back */
+  c->head = head + avail;
+  ECB_MEMORY_FENCE; /* publish head before checking tail and want_space */
+
+  /* a producer that saw a non-empty ring did not wake us up, so if */
+  /* messages are left, make sure we come back even if the caller stops reading */
+  c->tail_cache = c->tail;
+  if (c->tail_cache != c->head && c->read_loop)
+    ev_async_send(c->read_loop, &c->reader);
+
+  if (c->want_space) {
+    struct ev_loop* wloop = c->write_loop;
+
+    c->want_space = 0;
+
+    if (wloop)
+      ev_async_send(wloop, &c->writer);
+  }
+
+  return avail;
+}
+
+#endif
@@ -32,6 +32,7 @@
 #include <fcntl.h>
 #include <stdint.h>
 #include <sys/epoll.h>
+#include <sys/ioctl.h>
 #include <unistd.h>
 
 #define EV_EMASK_EPERM 0x80
@@ -51,11 +52,11 @@ static void epoll_modify(EV_P_ int fd, int oev, int nev) {
   if (!nev)
     return;
 
-  oldmask = anfds[fd].emask;
-  anfds[fd].emask = nev;
+  oldmask = ANFD_AT(fd).emask;
+  ANFD_AT(fd).emask = nev;
 
   /* store the generation counter in the upper 32 bits, the fd in the lower 32 bits */
-  ev.data.u64 = (uint64_t)(uint32_t)fd | ((uint64_t)(uint32_t)++anfds[fd].egen << 32);
+  ev.data.u64 = (uint64_t)(uint32_t)fd | ((uint64_t)(uint32_t)++ANFD_AT(fd).egen << 32);
   ev.events = (nev & EV_READ ? EPOLLIN : 0) | (nev & EV_WRITE ? EPOLLOUT : 0);
 
   if (ecb_expect_true(!epoll_ctl(backend_fd, oev && oldmask != nev ? EPOLL_CTL_MOD : EPOLL_CTL_ADD, fd, &ev)))
@@ -81,7 +82,7 @@ static void epoll_modify(EV_P_ int fd, int oev, int nev) {
   else if (ecb_expect_true(errno == EPERM)) {
     /* EPERM means the fd is always ready, but epoll is too snobbish */
     /* to handle it, unlike select or poll. */
-    anfds[fd].emask = EV_EMASK_EPERM;
+    ANFD_AT(fd).emask = EV_EMASK_EPERM;
 
     /* add fd to epoll_eperms, if not already inside */
     if (!(oldmask & EV_EMASK_EPERM)) {
@@ -99,7 +100,19 @@ static void epoll_modify(EV_P_ int fd, int oev, int nev) {
 
 dec_egen:
   /* we didn't successfully call epoll_ctl, so decrement the generation counter again */
-  --anfds[fd].egen;
+  --ANFD_AT(fd).egen;
+}
+
+/* epoll_modify leaves unwatched fds in the set, this really takes one out, */
+/* for fds that another loop is about to watch */
+ecb_cold static void epoll_forget(EV_P_ int fd) {
+  struct epoll_event ev;
+
+  /* pre-2.6.9 kernels want a non-null event even for EPOLL_CTL_DEL */
+  memset(&ev, 0, sizeof(ev));
+
+  if (!epoll_ctl(backend_fd, EPOLL_CTL_DEL, fd, &ev))
+    ANFD_AT(fd).emask = 0;
 }
 
 static void epoll_poll(EV_P_ ev_tstamp timeout) {
@@ -126,7 +139,7 @@ static void epoll_poll(EV_P_ ev_tstamp timeout) {
     struct epoll_event* ev = epoll_events + i;
 
     int fd = (uint32_t)ev->data.u64; /* mask out the lower 32 bits */
-    int want = anfds[fd].events;
+    int want = ANFD_AT(fd).events;
     int got = ((ev->events & (EPOLLOUT | EPOLLERR | EPOLLHUP)) ? EV_WRITE : 0) |
               ((ev->events & (EPOLLIN | EPOLLERR | EPOLLHUP)) ? EV_READ : 0);
 
@@ -136,14 +149,14 @@ static void epoll_poll(EV_P_ ev_tstamp timeout) {
      * other spurious notifications will be found by epoll_ctl, below
      * we assume that fd is always in range, as we never shrink the anfds array
      */
-    if (ecb_expect_false((uint32_t)anfds[fd].egen != (uint32_t)(ev->data.u64 >> 32))) {
+    if (ecb_expect_false((uint32_t)ANFD_AT(fd).egen != (uint32_t)(ev->data.u64 >> 32))) {
       /* recreate kernel state */
       postfork |= 2;
       continue;
     }
 
     if (ecb_expect_false(got & ~want)) {
-      anfds[fd].emask = want;
+      ANFD_AT(fd).emask = want;
 
       /*
        * we received an event but are not interested in it, try mod or del
@@ -171,21 +184,21 @@ static void epoll_poll(EV_P_ ev_tstamp timeout) {
 
   /* if the receive array was full, increase its size */
   if (ecb_expect_false(eventcnt == epoll_eventmax)) {
-    ev_free(epoll_events);
+    loop_free(epoll_events);
     epoll_eventmax = array_nextsize(sizeof(struct epoll_event), epoll_eventmax, epoll_eventmax + 1);
-    epoll_events = (struct epoll_event*)ev_malloc(sizeof(struct epoll_event) * epoll_eventmax);
+    epoll_events = (struct epoll_event*)loop_malloc(sizeof(struct epoll_event) * epoll_eventmax);
   }
 
   /* now synthesize events for all fds where epoll fails, while select works... */
   for (i = epoll_epermcnt; i--;) {
     int fd = epoll_eperms[i];
-    unsigned char events = anfds[fd].events & (EV_READ | EV_WRITE);
+    unsigned char events = ANFD_AT(fd).events & (EV_READ | EV_WRITE);
 
-    if (anfds[fd].emask & EV_EMASK_EPERM && events)
+    if (ANFD_AT(fd).emask & EV_EMASK_EPERM && events)
       fd_event(EV_A_ fd, events);
     else {
       epoll_eperms[i] = epoll_eperms[--epoll_epermcnt];
-      anfds[fd].emask = 0;
+      ANFD_AT(fd).emask = 0;
     }
   }
 }
@@ -208,6 +221,38 @@ static int epoll_epoll_create(void) {
   return fd;
 }
 
+/* EPIOCSPARAMS is linux 6.9+, older headers lack it */
+#ifndef EPIOCSPARAMS
+struct epoll_params {
+  uint32_t busy_poll_usecs;
+  uint16_t busy_poll_budget;
+  uint8_t prefer_busy_poll;
+  uint8_t __pad;
+};
+#define EPIOCSPARAMS _IOW(0x8A, 0x01, struct epoll_params)
+#endif
+
+/* let the kernel busy-poll the napi contexts of our sockets for as long as we spin */
+/* best effort: older kernels and non-napi fds simply ignore or reject this */
+static void epoll_busy_poll(EV_P) {
+  struct epoll_params p;
+  ev_tstamp usecs = busy_polltime * 1e6;
+
+  memset(&p, 0, sizeof(p));
+  p.busy_poll_usecs = usecs < (ev_tstamp)INT_MAX ? (uint32_t)usecs : (uint32_t)INT_MAX;
+  p.busy_poll_budget = p.busy_poll_usecs ? 8 : 0; /* the kernel's default per-poll packet budget */
+  p.prefer_busy_poll = !!p.busy_poll_usecs;
+
+  ioctl(backend_fd, EPIOCSPARAMS, &p);
+}
+
+/* for ev_loop_reserve and ev_loop_trim, only called outside of epoll_poll */
+ecb_cold static void epoll_events_resize(EV_P_ int cnt) {
+  loop_free(epoll_events);
+  epoll_eventmax = cnt;
+  epoll_events = (struct epoll_event*)loop_malloc(sizeof(struct epoll_event) * epoll_eventmax);
+}
+
 inline_size int epoll_init(EV_P_ int flags) {
   (void)flags;
 
@@ -219,13 +264,13 @@ inline_size int epoll_init(EV_P_ int flags) {
   backend_poll = epoll_poll;
 
   epoll_eventmax = 64; /* initial number of events receivable per poll */
-  epoll_events = (struct epoll_event*)ev_malloc(sizeof(struct epoll_event) * epoll_eventmax);
+  epoll_events = (struct epoll_event*)loop_malloc(sizeof(struct epoll_event) * epoll_eventmax);
 
   return EVBACKEND_EPOLL;
 }
 
 inline_size void epoll_destroy(EV_P) {
-  ev_free(epoll_events);
+  loop_free(epoll_events);
   array_free(epoll_eperm, EMPTY);
 }
 
@@ -235,5 +280,8 @@ ecb_cold static void epoll_fork(EV_P) {
   while ((backend_fd = epoll_epoll_create()) < 0)
     ev_syserr("(libev) epoll_create");
 
+  if (busy_polltime > EV_TS_CONST(0.))
+    epoll_busy_poll(EV_A);
+
   fd_rearm_all(EV_A);
 }
@@ -0,0 +1,213 @@
+/* src/ev_group.c
+ * loop groups: one loop per thread, fds handed out through ev_channel rings
+ */
+
+#if EV_GROUP_ENABLE
+
+struct ev_group_member {
+  struct ev_loop* loop;
+  struct ev_loop_group* group;
+  ev_channel chan;
+  ev_async stop;
+  pthread_t tid;
+  int idx;
+  int started;
+  int fds[EV_GROUP_QUEUESIZE];
+};
+
+struct ev_loop_group {
+  void (*conn_cb)(EV_P_ int fd, void* arg);
+  void* arg;
+  unsigned int flags;
+  unsigned int next;
+  int nloops;
+  struct ev_group_member members[1];
+};
+
+static void group_chan_cb(EV_P_ ev_channel* c, int revents) {
+  struct ev_group_member* m = (struct ev_group_member*)(((char*)c) - offsetof(struct ev_group_member, chan));
+  int fds[16];
+  unsigned int n, i;
+
+  (void)revents;
+
+  /* bounded, so a busy acceptor cannot starve the other watchers of this loop */
+  n = ev_channel_read(c, fds, sizeof(fds) / sizeof(fds[0]));
+
+  for (i = 0; i < n; ++i)
+    m->group->conn_cb(EV_A_ fds[i], m->group->arg);
+}
+
+static void group_stop_cb(EV_P_ ev_async* w, int revents) {
+  (void)w;
+  (void)revents;
+
+  ev_break(EV_A_ EVBREAK_ALL);
+}
+
+/* bind the calling thread to one cpu, silently ignored where unsupported */
+static void group_pin(int idx) {
+#if defined(__linux__) && defined(SYS_sched_setaffinity)
+  unsigned long mask[1024 / (8 * sizeof(unsigned long))];
+  long ncpu = sysconf(_SC_NPROCESSORS_ONLN);
+  int cpu;
+
+  if (ncpu <= 0)
+    return;
+
+  cpu = idx % ncpu;
+
+  if (cpu >= 1024)
+    return;
+
+  memset(mask, 0, sizeof(mask));
+  mask[cpu / (8 * sizeof(unsigned long))] |= 1UL << (cpu % (8 * sizeof(unsigned long)));
+  syscall(SYS_sched_setaffinity, 0, sizeof(mask), mask);
+#else
+  (void)idx;
+#endif
+}
+
+static void* group_thread(void* arg) {
+  struct ev_group_member* m = (struct ev_group_member*)arg;
+
+  if (m->group->flags & EVGROUP_PIN)
+    group_pin(m->idx);
+
+  ev_run(m->loop, 0);
+
+  return 0;
+}
+
+/* active watchers plus fds queued but not yet picked up; read racily from the acceptor */
+inline_size int group_load(EV_P_ ev_channel* c) {
+  return *(volatile int*)&activecnt + (int)(c->tail - c->head);
+}
+
+ecb_cold struct ev_loop_group* ev_loop_group_new(int nloops,
+                                                 unsigned int loop_flags,
+                                                 unsigned int group_flags,
+                                                 void (*conn_cb)(EV_P_ int fd, void* arg),
+                                                 void* arg) EV_NOEXCEPT {
+  struct ev_loop_group* g;
+  int i;
+
+  if (nloops <= 0)
+    return 0;
+
+  g = (struct ev_loop_group*)ev_malloc(sizeof(struct ev_loop_group) +
+                                       (nloops - 1) * sizeof(struct ev_group_member));
+  memset(g, 0, sizeof(struct ev_loop_group) + (nloops - 1) * sizeof(struct ev_group_member));
+
+  g->conn_cb = conn_cb;
+  g->arg = arg;
+  g->flags = group_flags;
+  g->nloops = nloops;
+
+  for (i = 0; i < nloops; ++i) {
+    struct ev_group_member* m = g->members + i;
+
+    m->loop = ev_loop_new(loop_flags);
+
+    if (!m->loop) {
+      g->nloops = i;
+      ev_loop_group_destroy(g);
+      return 0;
+    }
+
+    m->group = g;
+    m->idx = i;
+
+    ev_channel_init(&m->chan, m->fds, sizeof(int), EV_GROUP_QUEUESIZE, group_chan_cb, 0);
+    ev_channel_reader_start(m->loop, &m->chan);
+
+    ev_async_init(&m->stop, group_stop_cb);
+    ev_async_start(m->loop, &m->stop);
+  }
+
+  return g;
+}
+
+int ev_loop_group_count(struct ev_loop_group* g) EV_NOEXCEPT {
+  return g->nloops;
+}
+
+struct ev_loop* ev_loop_group_loop(struct ev_loop_group* g, int idx) EV_NOEXCEPT {
+  return g->members[idx].loop;
+}
+
+ecb_cold int ev_loop_group_start(struct ev_loop_group* g) EV_NOEXCEPT {
+  int i;
+
+  for (i = 0; i < g->nloops; ++i) {
+    struct ev_group_member* m = g->members + i;
+
+    if (m->started)
+      continue;
+
+    if (pthread_create(&m->tid, 0, group_thread, (void*)m))
+      return -1;
+
+    m->started = 1;
+  }
+
+  return 0;
+}
+
+int ev_loop_group_dispatch(struct ev_loop_group* g, int fd) EV_NOEXCEPT {
+  int first, i;
+
+  if (g->flags & EVGROUP_LEASTLOADED) {
+    int best = INT_MAX;
+
+    first = 0;
+
+    for (i = 0; i < g->nloops; ++i) {
+      int load = group_load(g->members[i].loop, &g->members[i].chan);
+
+      if (load < best) {
+        best = load;
+        first = i;
+      }
+    }
+  }
+  else
+    first = g->next++ % (unsigned int)g->nloops;
+
+  /* fall over to the next loop when a queue is full */
+  for (i = 0; i < g->nloops; ++i) {
+    struct ev_group_member* m = g->members + (first + i) % g->nloops;
+
+    if (ev_channel_write(&m->chan, &fd, 1))
+      return m->idx;
+  }
+
+  return -1;
+}
+
+ecb_cold void ev_loop_group_destroy(struct ev_loop_group* g) EV_NOEXCEPT {
+  int i, fd;
+
+  for (i = 0; i < g->nloops; ++i)
+    if (g->members[i].started)
+      ev_async_send(g->members[i].loop, &g->members[i].stop);
+
+  for (i = 0; i < g->nloops; ++i) {
+    struct ev_group_member* m = g->members + i;
+
+    if (m->started)
+      pthread_join(m->tid, 0);
+
+    /* fds that were handed off but never picked up are ours to close */
+    while (ev_channel_read(&m->chan, &fd, 1))
+      close(fd);
+
+    ev_channel_reader_stop(m->loop, &m->chan);
+    ev_async_stop(m->loop, &m->stop);
+    ev_loop_destroy(m->loop);
+  }
+
+  ev_free(g);
+}
+
+#endif
@@ -467,12 +467,12 @@ static void iouring_modify(EV_P_ int fd, int oev, int nev) {
      * be removed. Since we don't *really* have that, we pass in the old
      * generation counter - if that fails, too bad, it will hopefully be removed
      * at close time and then be ignored. */
-    sqe->addr = (uint32_t)fd | ((__u64)(uint32_t)anfds[fd].egen << 32);
+    sqe->addr = (uint32_t)fd | ((__u64)(uint32_t)ANFD_AT(fd).egen << 32);
     sqe->user_data = (uint64_t)-1;
     iouring_sqe_submit(EV_A_ sqe);
 
     /* increment generation counter to avoid handling old events */
-    ++anfds[fd].egen;
+    ++ANFD_AT(fd).egen;
   }
 
   if (nev) {
@@ -480,7 +480,7 @@ static void iouring_modify(EV_P_ int fd, int oev, int nev) {
     sqe->opcode = IORING_OP_POLL_ADD;
     sqe->fd = fd;
     sqe->addr = 0;
-    sqe->user_data = (uint32_t)fd | ((__u64)(uint32_t)anfds[fd].egen << 32);
+    sqe->user_data = (uint32_t)fd | ((__u64)(uint32_t)ANFD_AT(fd).egen << 32);
     sqe->poll_events = (nev & EV_READ ? POLLIN : 0) | (nev & EV_WRITE ? POLLOUT : 0);
     iouring_sqe_submit(EV_A_ sqe);
   }
@@ -569,7 +569,7 @@ inline_size void iouring_process_cqe(EV_P_ struct io_uring_cqe* cqe) {
   /* ignore event if generation doesn't match */
   /* other than skipping removal events, */
   /* this should actually be very rare */
-  if (ecb_expect_false(gen != (uint32_t)anfds[fd].egen))
+  if (ecb_expect_false(gen != (uint32_t)ANFD_AT(fd).egen))
     return;
 
   if (ecb_expect_false(res < 0)) {
@@ -593,7 +593,7 @@ inline_size void iouring_process_cqe(EV_P_ struct io_uring_cqe* cqe) {
 
   /* io_uring is oneshot, so we need to re-arm the fd next iteration */
   /* this also means we usually have to do at least one syscall per iteration */
-  anfds[fd].events = 0;
+  ANFD_AT(fd).events = 0;
   fd_change(EV_A_ fd, EV_ANFD_REIFY);
 }
 
@@ -86,9 +86,9 @@ static void kqueue_poll(EV_P_ ev_tstamp timeout) {
 
   /* need to resize so there is enough space for errors */
   if (kqueue_changecnt > kqueue_eventmax) {
-    ev_free(kqueue_events);
+    loop_free(kqueue_events);
     kqueue_eventmax = array_nextsize(sizeof(struct kevent), kqueue_eventmax, kqueue_changecnt);
-    kqueue_events = (struct kevent*)ev_malloc(sizeof(struct kevent) * kqueue_eventmax);
+    kqueue_events = (struct kevent*)loop_malloc(sizeof(struct kevent) * kqueue_eventmax);
   }
 
   EV_RELEASE_CB;
@@ -115,13 +115,13 @@ static void kqueue_poll(EV_P_ ev_tstamp timeout) {
       int err = (int)kev->data;
 
       /* we are only interested in errors for fds that we are interested in */
-      if (anfds[fd].events) {
+      if (ANFD_AT(fd).events) {
         if (err == ENOENT) /* resubmit changes on ENOENT */
-          kqueue_modify(EV_A_ fd, 0, anfds[fd].events);
+          kqueue_modify(EV_A_ fd, 0, ANFD_AT(fd).events);
         else if (err == EBADF) /* on EBADF, we re-check the fd */
         {
           if (fd_valid(fd))
-            kqueue_modify(EV_A_ fd, 0, anfds[fd].events);
+            kqueue_modify(EV_A_ fd, 0, ANFD_AT(fd).events);
           else {
             EV_ASSERT_MSG("libev: kqueue found invalid fd", 0);
             fd_kill(EV_A_ fd);
@@ -143,12 +143,19 @@ static void kqueue_poll(EV_P_ ev_tstamp timeout) {
   }
 
   if (ecb_expect_false(res == kqueue_eventmax)) {
-    ev_free(kqueue_events);
+    loop_free(kqueue_events);
     kqueue_eventmax = array_nextsize(sizeof(struct kevent), kqueue_eventmax, kqueue_eventmax + 1);
-    kqueue_events = (struct kevent*)ev_malloc(sizeof(struct kevent) * kqueue_eventmax);
+    kqueue_events = (struct kevent*)loop_malloc(sizeof(struct kevent) * kqueue_eventmax);
   }
 }
 
+/* for ev_loop_reserve and ev_loop_trim, only called outside of kqueue_poll */
+ecb_cold static void kqueue_events_resize(EV_P_ int cnt) {
+  loop_free(kqueue_events);
+  kqueue_eventmax = cnt;
+  kqueue_events = (struct kevent*)loop_malloc(sizeof(struct kevent) * kqueue_eventmax);
+}
+
 inline_size int kqueue_init(EV_P_ int flags) {
   /* initialize the kernel queue */
   kqueue_fd_pid = getpid();
@@ -162,7 +169,7 @@ inline_size int kqueue_init(EV_P_ int flags) {
   backend_poll = kqueue_poll;
 
   kqueue_eventmax = 64; /* initial number of events receivable per poll */
-  kqueue_events = (struct kevent*)ev_malloc(sizeof(struct kevent) * kqueue_eventmax);
+  kqueue_events = (struct kevent*)loop_malloc(sizeof(struct kevent) * kqueue_eventmax);
 
   kqueue_changes = 0;
   kqueue_changemax = 0;
@@ -172,8 +179,8 @@ inline_size int kqueue_init(EV_P_ int flags) {
 }
 
 inline_size void kqueue_destroy(EV_P) {
-  ev_free(kqueue_events);
-  ev_free(kqueue_changes);
+  loop_free(kqueue_events);
+  loop_free(kqueue_changes);
 }
 
 inline_size void kqueue_fork(EV_P) {
@@ -194,7 +194,7 @@ typedef struct linuxaio_iocb_block {
 
 inline_size ANIOCBP linuxaio_iocb_get(EV_P) {
   if (ecb_expect_false(!linuxaio_iocbfreelist)) {
-    linuxaio_iocb_block* block = (linuxaio_iocb_block*)ev_malloc(sizeof *block);
+    linuxaio_iocb_block* block = (linuxaio_iocb_block*)loop_malloc(sizeof *block);
     int i;
 
     block->next = linuxaio_iocbblocks;
@@ -234,10 +234,10 @@ ecb_cold static void linuxaio_free_iocbp(EV_P) {
   while (linuxaio_iocbblocks) {
     linuxaio_iocb_block* block = linuxaio_iocbblocks;
     linuxaio_iocbblocks = block->next;
-    ev_free(block);
+    loop_free(block);
   }
 
-  ev_free(linuxaio_iocbps);
+  loop_free(linuxaio_iocbps);
   linuxaio_iocbps = 0;
 }
 
@@ -250,7 +250,7 @@ static void linuxaio_modify(EV_P_ int fd, int oev, int nev) {
   }
 
   ANIOCBP iocb = linuxaio_iocbps[fd];
-  ANFD* anfd = &anfds[fd];
+  ANFD* anfd = &ANFD_AT(fd);
 
   if (ecb_expect_false(iocb->io.aio_reqprio < 0)) {
     /* we handed this fd over to epoll, so undo this first */
@@ -302,7 +302,7 @@ static void linuxaio_epoll_cb(EV_P_ struct ev_io* w, int revents) {
 }
 
 inline_speed void linuxaio_fd_rearm(EV_P_ int fd) {
-  anfds[fd].events = 0;
+  ANFD_AT(fd).events = 0;
   linuxaio_iocbps[fd]->io.aio_buf = 0;
   fd_change(EV_A_ fd, EV_ANFD_REIFY);
 }
@@ -316,7 +316,7 @@ static void linuxaio_parse_events(EV_P_ struct io_event* ev, int nr) {
     EV_ASSERT_MSG("libev: iocb fd must be in-bounds", fd >= 0 && fd < anfdmax);
 
     /* only accept events if generation counter matches */
-    if (ecb_expect_true(gen == (uint32_t)anfds[fd].egen)) {
+    if (ecb_expect_true(gen == (uint32_t)ANFD_AT(fd).egen)) {
       /* feed events, we do not expect or handle POLLNVAL */
       fd_event(EV_A_ fd, (res & (POLLOUT | POLLERR | POLLHUP) ? EV_WRITE : 0) |
                              (res & (POLLIN | POLLERR | POLLHUP) ? EV_READ : 0));
@@ -460,7 +460,7 @@ static void linuxaio_poll(EV_P_ ev_tstamp timeout) {
         struct iocb* iocb = linuxaio_submits[submitted];
         const int fd = iocb->aio_fildes;
 
-        epoll_modify(EV_A_ fd, 0, anfds[fd].events);
+        epoll_modify(EV_A_ fd, 0, ANFD_AT(fd).events);
         iocb->aio_reqprio = -1; /* mark iocb as epoll */
 
         res = 1; /* skip this iocb - another iocb, another chance */
@@ -31,38 +31,135 @@ inline_size int array_nextsize(int elem, int cur, int cnt) EV_NOEXCEPT {
   return ncur;
 }
 
-ecb_noinline ecb_cold static void* array_realloc(int elem, void* base, int* cur, int cnt) EV_NOEXCEPT {
+ecb_noinline ecb_cold static void* array_realloc(EV_P_ int elem, void* base, int* cur, int cnt) EV_NOEXCEPT {
   *cur = array_nextsize(elem, *cur, cnt);
-  return ev_realloc(base, elem * *cur);
+  return loop_realloc(EV_A_ base, elem * *cur);
+}
+
+#if EV_USE_HUGEPAGES
+#define HUGE_PAGE (2L << 20)
+#define huge_size(size) (((size) + HUGE_PAGE - 1) & ~(HUGE_PAGE - 1))
+
+/* a 2MB-aligned private mapping, so the kernel can back it with huge pages */
+ecb_cold static void* huge_map(EV_P_ long size) {
+  char* base = (char*)mmap(0, size + HUGE_PAGE, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  char* aligned;
+
+  if (base == MAP_FAILED)
+    ev_alloc_fail(size);
+
+  aligned = (char*)(((uintptr_t)base + HUGE_PAGE - 1) & ~(uintptr_t)(HUGE_PAGE - 1));
+
+  if (aligned != base)
+    munmap(base, aligned - base);
+
+  munmap(aligned + size, base + HUGE_PAGE - aligned);
+
+  if (origflags & EVFLAG_HUGEPAGES)
+    madvise(aligned, size, MADV_HUGEPAGE);
+
+#if defined SYS_getcpu && defined SYS_mbind
+  /* prefer the node we run on, otherwise first touch (by the copy below) decides */
+  if (origflags & EVFLAG_NUMALOCAL) {
+    unsigned int cpu, node;
+
+    if (!syscall(SYS_getcpu, &cpu, &node, 0) && node < sizeof(unsigned long) * 8) {
+      unsigned long mask = 1UL << node;
+
+      syscall(SYS_mbind, aligned, size, 1 /* MPOL_PREFERRED */, &mask, sizeof(mask) * 8 + 1, 0);
+    }
+  }
+#endif
+
+  return aligned;
+}
+#endif
+
+/* resize an array that may get big enough for huge pages to be worth it, */
+/* it lives in its own mapping while it is at least HUGE_PAGE large */
+ecb_noinline ecb_cold static void* array_resize_huge(EV_P_ int elem, void* base, int* cur, int ncur) EV_NOEXCEPT {
+#if EV_USE_HUGEPAGES
+  long osize = (long)elem * *cur;
+  long nsize = (long)elem * ncur;
+
+  if (ecb_expect_false(origflags & (EVFLAG_HUGEPAGES | EVFLAG_NUMALOCAL))
+#if EV_MULTIPLICITY
+      && !alloc_cb
+#endif
+      && (osize >= HUGE_PAGE || nsize >= HUGE_PAGE)) {
+    void* nbase = nsize >= HUGE_PAGE ? huge_map(EV_A_ huge_size(nsize)) : loop_malloc(nsize);
+
+    if (base && nbase)
+      memcpy(nbase, base, osize < nsize ? osize : nsize);
+
+    if (osize >= HUGE_PAGE)
+      munmap(base, huge_size(osize));
+    else
+      loop_free(base);
+
+    *cur = ncur;
+    return nbase;
+  }
+#endif
+
+  *cur = ncur;
+  return loop_realloc(EV_A_ base, (long)elem * ncur);
 }
 
 #define array_needsize_noinit(base, offset, count)
 
 #define array_needsize_zerofill(base, offset, count) memset((void*)(base + offset), 0, sizeof(*(base)) * (count))
 
-#define array_needsize(type, base, cur, cnt, init)                      \
-  if (ecb_expect_false((cnt) > (cur))) {                                \
-    ecb_unused int ocur_ = (cur);                                       \
-    (base) = (type*)array_realloc(sizeof(type), (base), &(cur), (cnt)); \
-    init((base), ocur_, ((cur) - ocur_));                               \
+#define array_needsize(type, base, cur, cnt, init)                            \
+  if (ecb_expect_false((cnt) > (cur))) {                                      \
+    ecb_unused int ocur_ = (cur);                                             \
+    (base) = (type*)array_realloc(EV_A_ sizeof(type), (base), &(cur), (cnt)); \
+    init((base), ocur_, ((cur) - ocur_));                                     \
   }
 
-#if 0
-#define array_slim(type, stem)                                          \
-  if (stem##max < array_roundsize(stem##cnt >> 2)) {                    \
-    stem##max = array_roundsize(stem##cnt >> 1);                        \
-    base = (type*)ev_realloc(base, sizeof(type) * (stem##max));         \
-    fprintf(stderr, "slimmed down " #stem " to %d\n", stem##max); /*D*/ \
+#define array_needsize_huge(type, base, cur, cnt, init)                                             \
+  if (ecb_expect_false((cnt) > (cur))) {                                                            \
+    ecb_unused int ocur_ = (cur);                                                                   \
+    (base) = (type*)array_resize_huge(EV_A_ sizeof(type), (base), &(cur),                           \
+                                      array_nextsize(sizeof(type), (cur), (cnt)));                  \
+    init((base), ocur_, ((cur) - ocur_));                                                           \
   }
-#endif
+
+/* shrink an array to what cnt elements need, but only if that frees at least half of it */
+ecb_noinline ecb_cold static void* array_trim(EV_P_ int elem, void* base, int* cur, int cnt, int huge) EV_NOEXCEPT {
+  int ncur = cnt ? array_nextsize(elem, 0, cnt) : 0;
+
+  if (ncur == *cur || ncur > *cur >> 1)
+    return base;
+
+  if (huge)
+    return array_resize_huge(EV_A_ elem, base, cur, ncur);
+
+  *cur = ncur;
+  return loop_realloc(EV_A_ base, (long)elem * ncur);
+}
+
+#define array_shrink(type, stem, idx, cnt, keep) \
+  stem##s idx = (type*)array_trim(EV_A_ sizeof(type), stem##s idx, &stem##max idx, (cnt) > (keep) ? (cnt) : (keep), 0)
+
+#define array_shrink_huge(type, stem, idx, cnt, keep) \
+  stem##s idx = (type*)array_trim(EV_A_ sizeof(type), stem##s idx, &stem##max idx, (cnt) > (keep) ? (cnt) : (keep), 1)
 
 #define array_free(stem, idx)        \
-  ev_free(stem##s idx);              \
+  loop_free(stem##s idx);            \
   stem##cnt idx = stem##max idx = 0; \
   stem##s idx = 0
 
 /*****************************************************************************/
 
+#if EV_FEATURE_API
+/* deadlines live beside pendings, so loops that never use edf do not pay for them */
+inline_size void edf_track(EV_P_ int pri, int idx, ev_tstamp deadline) {
+  array_needsize(ev_tstamp, pendingdls[pri], pendingdlmax[pri], idx + 1, array_needsize_noinit);
+  pendingdls[pri][idx] = deadline;
+}
+#endif
+
 /* dummy callback for pending events */
 ecb_noinline static void pendingcb(EV_P_ ev_prepare* w, int revents) {
   (void)loop;
@@ -81,10 +178,12 @@ ecb_noinline void ev_feed_event(EV_P_ void* w, int revents) EV_NOEXCEPT {
     array_needsize(ANPENDING, pendings[pri], pendingmax[pri], w_->pending, array_needsize_noinit);
     pendings[pri][w_->pending - 1].w = w_;
     pendings[pri][w_->pending - 1].events = revents;
+#if EV_FEATURE_API
+    if (ecb_expect_false(edf_tracked))
+      edf_track(EV_A_ pri, w_->pending - 1, edf_active ? ev_rt_now + pri_deadline[pri] : EV_TS_CONST(0.));
+#endif
+    pendingbits |= 1U << pri;
   }
-
-  if (pri > pendingpri)
-    pendingpri = pri;
 }
 
 inline_speed void feed_reverse(EV_P_ W w) {
@@ -107,22 +206,59 @@ inline_speed void queue_events(EV_P_ W* events, int eventcnt, int type) {
 
 /*****************************************************************************/
 
+#if EV_FEATURE_API
+/* remember that w is ready for ev, until ev_io_eagain or ev_io_stop */
+ecb_noinline static void hot_add(EV_P_ ev_io* w, int ev) {
+  int i;
+
+  if (w->events & EV__IOHOT) {
+    for (i = 0; hots[i].w != w; ++i)
+      ;
+
+    hots[i].events |= ev;
+    return;
+  }
+
+  w->events |= EV__IOHOT;
+  array_needsize(ANHOT, hots, hotmax, hotcnt + 1, array_needsize_noinit);
+  hots[hotcnt].w = w;
+  hots[hotcnt].events = ev;
+  ++hotcnt;
+}
+
+inline_size void hot_del(EV_P_ ev_io* w) {
+  int i;
+
+  for (i = 0; hots[i].w != w; ++i)
+    ;
+
+  hots[i] = hots[--hotcnt];
+  w->events &= ~EV__IOHOT;
+}
+#endif
+
 inline_speed void fd_event_nocheck(EV_P_ int fd, int revents) {
-  ANFD* anfd = anfds + fd;
+  ANFD* anfd = &ANFD_AT(fd);
   ev_io* w;
 
   for (w = (ev_io*)anfd->head; w; w = (ev_io*)((WL)w)->next) {
     int ev = w->events & revents;
 
-    if (ev)
+    if (ev) {
       ev_feed_event(EV_A_(W) w, ev);
+
+#if EV_FEATURE_API
+      if (ecb_expect_false(w->events & EV_SPECULATIVE))
+        hot_add(EV_A_ w, ev);
+#endif
+    }
   }
 }
 
 /* do not submit kernel events for fds that have reify set */
 /* because that means they changed while we were polling for new events */
 inline_speed void fd_event(EV_P_ int fd, int revents) {
-  ANFD* anfd = anfds + fd;
+  ANFD* anfd = &ANFD_AT(fd);
 
   if (ecb_expect_true(!anfd->reify))
     fd_event_nocheck(EV_A_ fd, revents);
@@ -133,6 +269,61 @@ void ev_feed_fd_event(EV_P_ int fd, int revents) EV_NOEXCEPT {
     fd_event_nocheck(EV_A_ fd, revents);
 }
 
+/* fdbits has a bit for every fd with watchers or a kernel mask, fdsums one per non-zero fdbits word */
+inline_size void fd_mark(EV_P_ int fd) {
+  int word = fd >> 6;
+
+  if (ecb_expect_false(word >= fdbitmax)) {
+    array_needsize(uint64_t, fdbits, fdbitmax, word + 1, array_needsize_zerofill);
+    array_needsize(uint64_t, fdsums, fdsummax, (fdbitmax + 63) >> 6, array_needsize_zerofill);
+  }
+
+  if (!fdbits[word])
+    fdsums[word >> 6] |= (uint64_t)1 << (word & 63);
+
+  fdbits[word] |= (uint64_t)1 << (fd & 63);
+}
+
+inline_size void fd_unmark(EV_P_ int fd) {
+  int word = fd >> 6;
+
+  fdbits[word] &= ~((uint64_t)1 << (fd & 63));
+
+  if (!fdbits[word])
+    fdsums[word >> 6] &= ~((uint64_t)1 << (word & 63));
+}
+
+/* the first marked fd >= fd, or -1 */
+ecb_noinline static int fd_next(EV_P_ int fd) {
+  int word = fd >> 6;
+  int sum;
+  uint64_t bits;
+
+  if (word >= fdbitmax)
+    return -1;
+
+  bits = fdbits[word] & (~(uint64_t)0 << (fd & 63));
+
+  if (bits)
+    return (word << 6) + ecb_ctz64(bits);
+
+  ++word;
+
+  for (sum = word >> 6; sum < fdsummax; ++sum) {
+    bits = fdsums[sum];
+
+    if (sum == word >> 6)
+      bits &= ~(uint64_t)0 << (word & 63);
+
+    if (bits) {
+      word = (sum << 6) + ecb_ctz64(bits);
+      return (word << 6) + ecb_ctz64(fdbits[word]);
+    }
+  }
+
+  return -1;
+}
+
 /* make sure the external fd watch events are in-sync */
 /* with the kernel/libev internal state */
 inline_size void fd_reify(EV_P) {
@@ -153,9 +344,9 @@ inline_size void fd_reify(EV_P) {
 #if EV_SELECT_IS_WINSOCKET || EV_USE_IOCP
   for (i = 0; i < changecnt; ++i) {
     int fd = fdchanges[i];
-    ANFD* anfd = anfds + fd;
+    ANFD* anfd = &ANFD_AT(fd);
 
-    if (anfd->reify & EV__IOFDSET && anfd->head) {
+    if (anfd->reify & EV_ANFD_IOFDSET && anfd->head) {
       SOCKET handle = EV_FD_TO_WIN32_HANDLE(fd);
       unsigned long arg = 0;
 
@@ -164,34 +355,34 @@ inline_size void fd_reify(EV_P) {
       /* handle changed, but fd didn't - we need to do it in two steps */
       backend_modify(EV_A_ fd, anfd->events, 0);
       anfd->events = 0;
-      anfd->handle = handle;
+      anfdxs[fd].handle = handle;
     }
   }
 #endif
 
   for (i = 0; i < changecnt; ++i) {
     int fd = fdchanges[i];
-    ANFD* anfd = anfds + fd;
-    ev_io* w;
+    ANFD* anfd = &ANFD_AT(fd);
+    ANFDCNT* cnt = &ANFDCNT_AT(fd);
 
     unsigned char o_events = anfd->events;
-    unsigned int o_reify = anfd->reify;
+    unsigned char o_reify = anfd->reify;
 
     anfd->reify = 0;
 
     /*if (ecb_expect_true (o_reify & EV_ANFD_REIFY)) probably a deoptimisation */
     {
-      anfd->events = 0;
-
-      for (w = (ev_io*)anfd->head; w; w = (ev_io*)((WL)w)->next)
-        anfd->events |= (unsigned char)w->events;
+      anfd->events = (cnt->readers ? EV_READ : 0) | (cnt->writers ? EV_WRITE : 0);
 
       if (o_events != anfd->events)
-        o_reify = EV__IOFDSET; /* actually |= */
+        o_reify = EV_ANFD_IOFDSET; /* actually |= */
     }
 
-    if (o_reify & EV__IOFDSET)
+    if (o_reify & EV_ANFD_IOFDSET)
       backend_modify(EV_A_ fd, o_events, anfd->events);
+
+    if (ecb_expect_false(!anfd->head && !anfd->events))
+      fd_unmark(EV_A_ fd);
   }
 
   /* normally, fdchangecnt hasn't changed. if it has, then new fds have been added.
@@ -204,10 +395,44 @@ inline_size void fd_reify(EV_P) {
   fdchangecnt -= changecnt;
 }
 
+/* make sure anfds covers fd */
+inline_size void fd_need(EV_P_ int fd) {
+#if EV_FD_PAGES
+  int page = fd >> ANFD_PAGE_SHIFT;
+
+  if (ecb_expect_false(page >= anfdpagemax)) {
+    int opagemax = anfdpagemax;
+
+    anfds = (ANFDSLOT*)array_realloc(EV_A_ sizeof(ANFDSLOT), anfds, &anfdpagemax, page + 1);
+
+    while (opagemax < anfdpagemax)
+      anfds[opagemax++] = (ANFDPAGE*)&anfd_zero_page;
+
+    anfdmax = anfdpagemax << ANFD_PAGE_SHIFT;
+  }
+
+  if (ecb_expect_false(anfds[page] == &anfd_zero_page)) {
+    anfds[page] = (ANFDPAGE*)loop_malloc(sizeof(ANFDPAGE));
+    memset(anfds[page], 0, sizeof(ANFDPAGE));
+  }
+#else
+  if (ecb_expect_false(fd >= anfdmax)) {
+    int ocur = anfdmax;
+    int cntmax = anfdmax;
+    int ncur = array_nextsize(sizeof(ANFD), anfdmax, fd + 1);
+
+    anfdcnts = (ANFDCNT*)array_resize_huge(EV_A_ sizeof(ANFDCNT), anfdcnts, &cntmax, ncur);
+    anfds = (ANFD*)array_resize_huge(EV_A_ sizeof(ANFD), anfds, &anfdmax, ncur);
+    memset(anfds + ocur, 0, sizeof(ANFD) * (anfdmax - ocur));
+    memset(anfdcnts + ocur, 0, sizeof(ANFDCNT) * (anfdmax - ocur));
+  }
+#endif
+}
+
 /* something about the given fd changed */
 inline_size void fd_change(EV_P_ int fd, int flags) {
-  unsigned int reify = anfds[fd].reify;
-  anfds[fd].reify = reify | flags;
+  unsigned char reify = ANFD_AT(fd).reify;
+  ANFD_AT(fd).reify = reify | flags;
 
   if (ecb_expect_true(!reify)) {
     ++fdchangecnt;
@@ -216,12 +441,14 @@ inline_size void fd_change(EV_P_ int fd, int flags) {
   }
 }
 
+inline_speed void io_stop(EV_P_ ev_io* w);
+
 /* the given fd is invalid/unusable, so make sure it doesn't hurt us anymore */
 inline_speed ecb_cold void fd_kill(EV_P_ int fd) {
   ev_io* w;
 
-  while ((w = (ev_io*)anfds[fd].head)) {
-    ev_io_stop(EV_A_ w);
+  while ((w = (ev_io*)ANFD_AT(fd).head)) {
+    io_stop(EV_A_ w);
     ev_feed_event(EV_A_(W) w, EV_ERROR | EV_READ | EV_WRITE);
   }
 }
@@ -239,32 +466,33 @@ inline_size ecb_cold int fd_valid(int fd) {
 ecb_noinline ecb_cold static void fd_ebadf(EV_P) {
   int fd;
 
-  for (fd = 0; fd < anfdmax; ++fd)
-    if (anfds[fd].events)
+  for (fd = fd_next(EV_A_ 0); fd >= 0; fd = fd_next(EV_A_ fd + 1))
+    if (ANFD_AT(fd).events)
       if (!fd_valid(fd) && errno == EBADF)
         fd_kill(EV_A_ fd);
 }
 
 /* called on ENOMEM in select/poll to kill some fds and retry */
 ecb_noinline ecb_cold static void fd_enomem(EV_P) {
-  int fd;
+  int fd, last = -1;
 
-  for (fd = anfdmax; fd--;)
-    if (anfds[fd].events) {
-      fd_kill(EV_A_ fd);
-      break;
-    }
+  for (fd = fd_next(EV_A_ 0); fd >= 0; fd = fd_next(EV_A_ fd + 1))
+    if (ANFD_AT(fd).events)
+      last = fd;
+
+  if (last >= 0)
+    fd_kill(EV_A_ last);
 }
 
 /* usually called after fork if backend needs to re-arm all fds from scratch */
 ecb_noinline static void fd_rearm_all(EV_P) {
   int fd;
 
-  for (fd = 0; fd < anfdmax; ++fd)
-    if (anfds[fd].events) {
-      anfds[fd].events = 0;
-      anfds[fd].emask = 0;
-      fd_change(EV_A_ fd, EV__IOFDSET | EV_ANFD_REIFY);
+  for (fd = fd_next(EV_A_ 0); fd >= 0; fd = fd_next(EV_A_ fd + 1))
+    if (ANFD_AT(fd).events) {
+      ANFD_AT(fd).events = 0;
+      ANFD_AT(fd).emask = 0;
+      fd_change(EV_A_ fd, EV_ANFD_IOFDSET | EV_ANFD_REIFY);
     }
 }
 
@@ -470,6 +698,10 @@ ecb_noinline ecb_cold static void evpipe_init(EV_P) {
     ev_io_set(&pipe_w, evpipe[0] < 0 ? evpipe[1] : evpipe[0], EV_READ);
     ev_io_start(EV_A_ & pipe_w);
     ev_unref(EV_A); /* watcher should not keep loop alive */
+
+#if EV_USE_IO_MIGRATE
+    ev_atomic_store(&migrate_ready, 1);
+#endif
   }
 }
 
@@ -517,8 +749,109 @@ inline_speed void evpipe_write(EV_P_ EV_ATOMIC_T* flag) {
   }
 }
 
+#if EV_USE_ASYNC_MAP
+/* note that the async watcher at the given active index needs looking at. */
+/* the map is only a hint, w->sent stays authoritative, so aliasing of */
+/* indices modulo EV_ASYNC_HASHSIZE and stale bits are harmless */
+inline_speed void async_map_set(EV_P_ int idx) {
+  unsigned int bit = idx & ((EV_ASYNC_HASHSIZE) - 1);
+
+  /* no async watcher was ever started, so there is nobody to tell */
+  if (ecb_expect_false(!async_map))
+    return;
+
+  ev_atomic_or(&async_map[bit >> 6], (uint64_t)1 << (bit & 63));
+  ev_atomic_or(&async_mapsum, (uint64_t)1 << (bit >> 6));
+}
+
+/* feed all async watchers marked in the map, costs O(signalled watchers) */
+/* as long as there are no more than EV_ASYNC_HASHSIZE async watchers */
+inline_size void async_map_drain(EV_P) {
+  uint64_t sum = ev_atomic_xchg(&async_mapsum, 0);
+
+  while (sum) {
+    int word = ecb_ctz64(sum);
+    uint64_t bits = ev_atomic_xchg(&async_map[word], 0);
+
+    sum &= sum - 1;
+
+    while (bits) {
+      int i;
+
+      for (i = word * 64 + ecb_ctz64(bits); i < asynccnt; i += (EV_ASYNC_HASHSIZE))
+        if (asyncs[i]->sent) {
+          asyncs[i]->sent = 0;
+          ECB_MEMORY_FENCE_RELEASE;
+          ev_feed_event(EV_A_ asyncs[i], EV_ASYNC);
+        }
+
+      bits &= bits - 1;
+    }
+  }
+}
+#endif
+
+#if EV_USE_IO_MIGRATE
+/* start the io watchers other loops handed to us, in the order they were migrated */
+inline_size void migrate_drain(EV_P) {
+  ev_io* list = (ev_io*)ev_atomic_xchg(&migrate_in, (ev_io*)0);
+  ev_io* todo = 0;
+
+  /* migrate_in is a lifo */
+  while (list) {
+    ev_io* next = (ev_io*)((WL)list)->next;
+
+    ((WL)list)->next = (WL)todo;
+    todo = list;
+    list = next;
+  }
+
+  while (todo) {
+    ev_io* w = todo;
+    int revents = w->events >> EV__IOMIGRATED_SHIFT;
+
+    todo = (ev_io*)((WL)w)->next;
+    w->events &= EV_READ | EV_WRITE | EV_SPECULATIVE;
+    w->fd |= EV__IOFDSET; /* new loop, new backend registration */
+    ev_io_start(EV_A_ w);
+
+    if (revents)
+      ev_feed_event(EV_A_ w, revents);
+  }
+}
+#endif
+
+#if EV_WORK_ENABLE
+/* hand finished ev_work watchers back to their callbacks, in completion order */
+inline_size void work_drain(EV_P) {
+  ev_work* list = (ev_work*)ev_atomic_xchg(&work_completed, (ev_work*)0);
+  ev_work* todo = 0;
+
+  while (list) {
+    ev_work* next = list->next;
+
+    list->next = todo;
+    todo = list;
+    list = next;
+  }
+
+  while (todo) {
+    ev_work* w = todo;
+
+    todo = w->next;
+
+    /* like ev_stop, the pool no longer references the watcher */
+    w->active = 0;
+    ev_unref(EV_A);
+
+    if (!w->cancelled)
+      ev_feed_event(EV_A_(W) w, EV_WORK);
+  }
+}
+#endif
+
 /* called whenever the libev signal pipe */
-/* got some events (signal, async) */
+/* got some events (signal, async, migrated io, finished work) */
 static void pipecb(EV_P_ ev_io* iow, int revents) {
   int i;
 
@@ -569,12 +902,36 @@ static void pipecb(EV_P_ ev_io* iow, int revents) {
 
     ECB_MEMORY_FENCE;
 
+#if EV_USE_ASYNC_MAP
+    async_map_drain(EV_A);
+#else
     for (i = asynccnt; i--;)
       if (asyncs[i]->sent) {
         asyncs[i]->sent = 0;
         ECB_MEMORY_FENCE_RELEASE;
         ev_feed_event(EV_A_ asyncs[i], EV_ASYNC);
       }
+#endif
+  }
+#endif
+
+#if EV_USE_IO_MIGRATE
+  if (migrate_pending) {
+    migrate_pending = 0;
+
+    ECB_MEMORY_FENCE;
+
+    migrate_drain(EV_A);
+  }
+#endif
+
+#if EV_WORK_ENABLE
+  if (work_pending) {
+    work_pending = 0;
+
+    ECB_MEMORY_FENCE;
+
+    work_drain(EV_A);
   }
 #endif
 }
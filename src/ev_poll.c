@@ -155,6 +155,6 @@ inline_size int poll_init(EV_P_ int flags) {
 }
 
 inline_size void poll_destroy(EV_P) {
-  ev_free(pollidxs);
-  ev_free(polls);
+  loop_free(pollidxs);
+  loop_free(polls);
 }
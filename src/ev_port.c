@@ -108,14 +108,14 @@ static void port_poll(EV_P_ ev_tstamp timeout) {
       fd_event(EV_A_ fd, (port_events[i].portev_events & (POLLOUT | POLLERR | POLLHUP) ? EV_WRITE : 0) |
                              (port_events[i].portev_events & (POLLIN | POLLERR | POLLHUP) ? EV_READ : 0));
 
-      fd_change(EV_A_ fd, EV__IOFDSET);
+      fd_change(EV_A_ fd, EV_ANFD_IOFDSET);
     }
   }
 
   if (ecb_expect_false(nget == port_eventmax)) {
-    ev_free(port_events);
+    loop_free(port_events);
     port_eventmax = array_nextsize(sizeof(port_event_t), port_eventmax, port_eventmax + 1);
-    port_events = (port_event_t*)ev_malloc(sizeof(port_event_t) * port_eventmax);
+    port_events = (port_event_t*)loop_malloc(sizeof(port_event_t) * port_eventmax);
   }
 }
 
@@ -139,13 +139,13 @@ inline_size int port_init(EV_P_ int flags) {
   backend_poll = port_poll;
 
   port_eventmax = 64; /* initial number of events receivable per poll */
-  port_events = (port_event_t*)ev_malloc(sizeof(port_event_t) * port_eventmax);
+  port_events = (port_event_t*)loop_malloc(sizeof(port_event_t) * port_eventmax);
 
   return EVBACKEND_PORT;
 }
 
 inline_size void port_destroy(EV_P) {
-  ev_free(port_events);
+  loop_free(port_events);
 }
 
 inline_size void port_fork(EV_P) {
@@ -75,7 +75,7 @@ static void select_modify(EV_P_ int fd, int oev, int nev) {
 #if EV_SELECT_USE_FD_SET
 
 #if EV_SELECT_IS_WINSOCKET
-    SOCKET handle = anfds[fd].handle;
+    SOCKET handle = anfdxs[fd].handle;
 #else
     int handle = fd;
 #endif
@@ -109,12 +109,12 @@ static void select_modify(EV_P_ int fd, int oev, int nev) {
     if (ecb_expect_false(vec_max <= word)) {
       int new_max = word + 1;
 
-      vec_ri = ev_realloc(vec_ri, new_max * NFDBYTES);
-      vec_ro = ev_realloc(vec_ro, new_max * NFDBYTES); /* could free/malloc */
-      vec_wi = ev_realloc(vec_wi, new_max * NFDBYTES);
-      vec_wo = ev_realloc(vec_wo, new_max * NFDBYTES); /* could free/malloc */
+      vec_ri = loop_realloc(EV_A_ vec_ri, new_max * NFDBYTES);
+      vec_ro = loop_realloc(EV_A_ vec_ro, new_max * NFDBYTES); /* could free/malloc */
+      vec_wi = loop_realloc(EV_A_ vec_wi, new_max * NFDBYTES);
+      vec_wo = loop_realloc(EV_A_ vec_wo, new_max * NFDBYTES); /* could free/malloc */
 #ifdef _WIN32
-      vec_eo = ev_realloc(vec_eo, new_max * NFDBYTES); /* could free/malloc */
+      vec_eo = loop_realloc(EV_A_ vec_eo, new_max * NFDBYTES); /* could free/malloc */
 #endif
 
       for (; vec_max < new_max; ++vec_max)
@@ -212,10 +212,10 @@ static void select_poll(EV_P_ ev_tstamp timeout) {
     int fd;
 
     for (fd = 0; fd < anfdmax; ++fd)
-      if (anfds[fd].events) {
+      if (ANFD_AT(fd).events) {
         int events = 0;
 #if EV_SELECT_IS_WINSOCKET
-        SOCKET handle = anfds[fd].handle;
+        SOCKET handle = anfdxs[fd].handle;
 #else
         int handle = fd;
 #endif
@@ -270,14 +270,14 @@ inline_size int select_init(EV_P_ int flags) {
   (void)flags;
 
 #if EV_SELECT_USE_FD_SET
-  vec_ri = ev_malloc(sizeof(fd_set));
+  vec_ri = loop_malloc(sizeof(fd_set));
   FD_ZERO((fd_set*)vec_ri);
-  vec_ro = ev_malloc(sizeof(fd_set));
-  vec_wi = ev_malloc(sizeof(fd_set));
+  vec_ro = loop_malloc(sizeof(fd_set));
+  vec_wi = loop_malloc(sizeof(fd_set));
   FD_ZERO((fd_set*)vec_wi);
-  vec_wo = ev_malloc(sizeof(fd_set));
+  vec_wo = loop_malloc(sizeof(fd_set));
 #ifdef _WIN32
-  vec_eo = ev_malloc(sizeof(fd_set));
+  vec_eo = loop_malloc(sizeof(fd_set));
 #endif
 #else
   vec_max = 0;
@@ -294,11 +294,11 @@ inline_size int select_init(EV_P_ int flags) {
 }
 
 inline_size void select_destroy(EV_P) {
-  ev_free(vec_ri);
-  ev_free(vec_ro);
-  ev_free(vec_wi);
-  ev_free(vec_wo);
+  loop_free(vec_ri);
+  loop_free(vec_ro);
+  loop_free(vec_wi);
+  loop_free(vec_wo);
 #ifdef _WIN32
-  ev_free(vec_eo);
+  loop_free(vec_eo);
 #endif
 }
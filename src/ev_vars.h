@@ -12,10 +12,12 @@ VARx(ev_tstamp, now_floor)     /* last time we refreshed rt_time */
     VARx(W*, rfeeds) VARx(int, rfeedmax) VARx(int, rfeedcnt)
 
         VAR(pendings, ANPENDING* pendings[NUMPRI]) VAR(pendingmax, int pendingmax[NUMPRI])
-            VAR(pendingcnt, int pendingcnt[NUMPRI]) VARx(int, pendingpri) /* highest priority currently pending */
+            VAR(pendingcnt, int pendingcnt[NUMPRI]) VARx(unsigned int, pendingbits) /* bit n set while pendingcnt[n] */
     VARx(ev_prepare, pending_w)                                           /* dummy pending watcher */
 
+
     VARx(ev_tstamp, io_blocktime) VARx(ev_tstamp, timeout_blocktime)
+        VARx(ev_tstamp, busy_polltime) /* spin with non-blocking polls this long before blocking */
 
         VARx(int, backend) VARx(int, activecnt) /* total number of active events ("refcount") */
     VARx(int, activeio)                         /* number of active fd watchers */
@@ -25,7 +27,18 @@ VARx(ev_tstamp, now_floor)     /* last time we refreshed rt_time */
     VAR(backend_modify, void (*backend_modify)(EV_P_ int fd, int oev, int nev))
         VAR(backend_poll, void (*backend_poll)(EV_P_ ev_tstamp timeout))
 
-            VARx(ANFD*, anfds) VARx(int, anfdmax)
+            VARx(ANFDSLOT*, anfds) VARx(int, anfdmax)
+#if EV_FD_PAGES || EV_GENWRAP
+    VARx(int, anfdpagemax) /* directory entries, anfdmax covers anfdpagemax pages */
+#endif
+#if !EV_FD_PAGES || EV_GENWRAP
+    VARx(ANFDCNT*, anfdcnts) /* reader/writer counts, anfdmax entries like anfds */
+#endif
+    VARx(uint64_t*, fdbits) VARx(int, fdbitmax) /* fds with watchers or a kernel mask, one bit each */
+    VARx(uint64_t*, fdsums) VARx(int, fdsummax) /* one bit per non-zero fdbits word */
+#if EV_USE_ANFDX || EV_GENWRAP
+    VARx(ANFDX*, anfdxs) VARx(int, anfdxmax) /* cold per-fd backend state, parallel to anfds */
+#endif
 
                 VAR(evpipe, int evpipe[2]) VARx(ev_io, pipe_w) VARx(EV_ATOMIC_T, pipe_write_wanted)
                     VARx(EV_ATOMIC_T, pipe_write_skipped)
@@ -144,16 +157,38 @@ VARx(ev_tstamp, now_floor)     /* last time we refreshed rt_time */
                         VARx(int, asynccnt)
 #endif
 
+#if EV_USE_ASYNC_MAP || EV_GENWRAP
+    VARx(uint64_t, async_mapsum)                           /* one bit per non-empty async_map word */
+    VARx(uint64_t*, async_map) /* sent hints, by active index % EV_ASYNC_HASHSIZE, from the first ev_async_start */
+#endif
+
+#if EV_USE_IO_MIGRATE || EV_GENWRAP
+    VARx(EV_ATOMIC_T, migrate_pending) /* set by other threads after pushing onto migrate_in */
+    VARx(ev_io*, migrate_in)           /* lifo of watchers migrated to this loop, linked via next */
+    VARx(EV_ATOMIC_T, migrate_ready)   /* set once the wakeup pipe exists, read by other threads */
+#endif
+
+#if EV_DEFER_ENABLE || EV_GENWRAP
+    VARx(ev_defer*, defer_head)     /* fifo of queued ev_defer calls */
+    VARx(ev_defer**, defer_tail)    /* next pointer to link the next call into */
+    VARx(unsigned int, defer_limit) /* calls per drain, 0 means unlimited */
+#endif
+
+#if EV_WORK_ENABLE || EV_GENWRAP
+    VARx(EV_ATOMIC_T, work_pending)   /* set by pool threads after pushing onto work_completed */
+    VARx(ev_work*, work_completed)    /* lifo of finished ev_work watchers, linked via next */
+#endif
+
 #if EV_USE_INOTIFY || EV_GENWRAP
                             VARx(int, fs_fd) VARx(ev_io, fs_w)
                                 VARx(char, fs_2625) /* whether we are running in linux 2.6.25 or newer */
-    VAR(fs_hash, ANFS fs_hash[EV_INOTIFY_HASHSIZE])
+    VARx(ANFS*, fs_hash) /* EV_INOTIFY_HASHSIZE buckets, once inotify is in use */
 #endif
 
         VARx(EV_ATOMIC_T, sig_pending)
 
 #if EV_USE_SIGNALFD || EV_GENWRAP
-            VARx(int, sigfd) VARx(ev_io, sigfd_w) VARx(sigset_t, sigfd_set)
+            VARx(int, sigfd) VARx(ev_io, sigfd_w) VARx(sigset_t*, sigfd_set)
 #endif
 
 #if EV_USE_TIMERFD || EV_GENWRAP
@@ -163,6 +198,14 @@ VARx(ev_tstamp, now_floor)     /* last time we refreshed rt_time */
 
         VARx(unsigned int, origflags) /* original loop flags */
 
+    VARx(struct ev_once_storage*, once_free) /* unused ev_once blocks, linked via arg */
+    VARx(void*, once_slabs)                  /* where they came from, linked via the first word */
+
+#if EV_MULTIPLICITY || EV_GENWRAP
+    VAR(alloc_cb, void* (*alloc_cb)(void* ptr, long size, void* ctx) EV_NOEXCEPT) /* 0 uses ev_set_allocator's */
+    VARx(void*, alloc_ctx)
+#endif
+
 #if EV_FEATURE_API || EV_GENWRAP
     VARx(unsigned int, loop_count) /* total number of loop iterations/blocks */
     VARx(unsigned int, loop_depth) /* #ev_run enters - #ev_run leaves */
@@ -171,6 +214,23 @@ VARx(ev_tstamp, now_floor)     /* last time we refreshed rt_time */
     /* C++ doesn't support the ev_loop_callback typedef here. stinks. */
     VAR(release_cb, void (*release_cb)(EV_P) EV_NOEXCEPT) VAR(acquire_cb, void (*acquire_cb)(EV_P) EV_NOEXCEPT)
         VAR(invoke_cb, ev_loop_callback invoke_cb)
+
+            VARx(unsigned int, invoke_budget)  /* max callbacks per ev_invoke_pending, 0 = unlimited */
+    VARx(ev_tstamp, invoke_timebudget)         /* max time per ev_invoke_pending, 0 = unlimited */
+    VARx(unsigned long, invoke_deferred)       /* callbacks left pending by an exhausted budget */
+    VARx(int, invoke_leftover)                 /* last budgeted invoke left pendings behind */
+    VAR(pri_weight, unsigned int pri_weight[NUMPRI]) /* per-priority weighted round-robin quantum */
+    VARx(int, pri_weighted)                    /* any pri_weight set */
+    VARx(int, pri_cursor)                      /* next priority in the round */
+    VAR(pri_deadline, ev_tstamp pri_deadline[NUMPRI]) /* per-priority latency budget for edf */
+    VARx(int, edf_active)                      /* any pri_deadline set */
+    VARx(int, edf_tracked)                     /* pendingdls are kept in step with pendings */
+    VAR(pendingdls, ev_tstamp* pendingdls[NUMPRI]) VAR(pendingdlmax, int pendingdlmax[NUMPRI]) /* deadlines, 0 = none */
+    VARx(ANEDF*, edfs) VARx(int, edfmax) VARx(int, edfcnt) /* edf dispatch heap */
+    VARx(unsigned int, invoke_passes)          /* ev_invoke_pending calls, to notice nested ones */
+    VARx(ANHOT*, hots) VARx(int, hotmax) VARx(int, hotcnt) /* speculative ev_io assumed ready */
+    VARx(int, hotpolls)                        /* iterations since hot fds last polled the kernel */
+    VARx(int, reserve_fds) VARx(int, reserve_timers) VARx(int, reserve_pending) /* ev_loop_trim keeps this much */
 #endif
 
 #undef VARx
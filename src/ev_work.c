@@ -0,0 +1,244 @@
+/* src/ev_work.c
+ * per-process worker pool for ev_work watchers
+ */
+
+#if EV_WORK_ENABLE
+
+#define EV_WORK_MAXTHREADS 64
+
+/* one submission queue per pool thread, idle threads steal from the others */
+typedef struct {
+  pthread_mutex_t lock;
+  ev_work* head;
+  ev_work* tail;
+} ANWORKQ;
+
+static pthread_once_t work_once = PTHREAD_ONCE_INIT;
+static pthread_once_t work_atfork_once = PTHREAD_ONCE_INIT;
+static pthread_mutex_t work_idle_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t work_idle_cond = PTHREAD_COND_INITIALIZER;
+static ANWORKQ work_queues[EV_WORK_MAXTHREADS];
+static ev_work* work_running[EV_WORK_MAXTHREADS]; /* only changed under a queue lock */
+static int work_threads;        /* 0 until the pool was started */
+static int work_threads_wanted; /* 0 means one per online cpu */
+static int work_sleepers;       /* protected by work_idle_lock */
+static int work_queued;         /* submitted but not yet taken, atomic */
+static unsigned int work_next;  /* round-robin submission, atomic */
+
+ecb_cold void ev_set_work_threads(int threads) EV_NOEXCEPT {
+  work_threads_wanted = threads;
+}
+
+static void work_push(ANWORKQ* q, ev_work* w) {
+  w->next = 0;
+
+  pthread_mutex_lock(&q->lock);
+
+  if (q->tail)
+    q->tail->next = w;
+  else
+    q->head = w;
+
+  q->tail = w;
+
+  pthread_mutex_unlock(&q->lock);
+}
+
+/* the taken watcher is recorded as running, so a fork never loses it */
+static ev_work* work_pop(ANWORKQ* q, int self) {
+  ev_work* w;
+
+  /* cheap unlocked peek, so stealing from empty queues does not contend */
+  if (!*(ev_work* volatile*)&q->head)
+    return 0;
+
+  pthread_mutex_lock(&q->lock);
+
+  w = q->head;
+
+  if (w) {
+    q->head = w->next;
+
+    if (!q->head)
+      q->tail = 0;
+
+    work_running[self] = w;
+  }
+
+  pthread_mutex_unlock(&q->lock);
+
+  return w;
+}
+
+/* push onto the origin loop's completion list, waking it only if needed */
+inline_speed void work_complete(EV_P_ ev_work* w) {
+  ev_work* head = work_completed;
+
+  do
+    w->next = head;
+  while (!ev_atomic_cas(&work_completed, &head, w));
+
+  evpipe_write(EV_A_ & work_pending);
+}
+
+static void* work_thread(void* arg) {
+  int self = (int)(long)arg;
+
+  for (;;) {
+    int n = ev_atomic_load(&work_threads);
+    ev_work* w = work_pop(&work_queues[self], self);
+    int i;
+
+    for (i = 1; !w && i < n; ++i)
+      w = work_pop(&work_queues[(self + i) % n], self);
+
+    if (w) {
+      ev_atomic_sub(&work_queued, 1);
+
+      if (!w->cancelled)
+        w->work(w);
+
+      pthread_mutex_lock(&work_queues[self].lock);
+      work_complete(w->origin, w);
+      work_running[self] = 0;
+      pthread_mutex_unlock(&work_queues[self].lock);
+      continue;
+    }
+
+    pthread_mutex_lock(&work_idle_lock);
+    ++work_sleepers;
+
+    while (!ev_atomic_load(&work_queued))
+      pthread_cond_wait(&work_idle_cond, &work_idle_lock);
+
+    --work_sleepers;
+    pthread_mutex_unlock(&work_idle_lock);
+  }
+
+  return 0;
+}
+
+/* fork only happens while no pool lock is held, so each watcher is in */
+/* exactly one queue, running slot or completion list */
+ecb_cold static void work_atfork_prepare(void) {
+  int n = ev_atomic_load(&work_threads);
+  int i;
+
+  pthread_mutex_lock(&work_idle_lock);
+
+  for (i = 0; i < n; ++i)
+    pthread_mutex_lock(&work_queues[i].lock);
+}
+
+ecb_cold static void work_atfork_parent(void) {
+  int n = ev_atomic_load(&work_threads);
+  int i;
+
+  for (i = n; i--;)
+    pthread_mutex_unlock(&work_queues[i].lock);
+
+  pthread_mutex_unlock(&work_idle_lock);
+}
+
+/* the child has no pool threads: everything they owned is handed back */
+/* cancelled, and the pool starts again on the next ev_work_start */
+ecb_cold static void work_fork_cancel(ev_work* w) {
+  EV_P = w->origin;
+
+  w->cancelled = 1;
+  w->next = work_completed;
+  work_completed = w;
+  work_pending = 1;
+}
+
+ecb_cold static void work_atfork_child(void) {
+  pthread_once_t once = PTHREAD_ONCE_INIT;
+  int n = work_threads;
+  int i;
+
+  for (i = 0; i < n; ++i) {
+    ev_work* w = work_queues[i].head;
+
+    while (w) {
+      ev_work* next = w->next;
+
+      work_fork_cancel(w);
+      w = next;
+    }
+
+    if (work_running[i])
+      work_fork_cancel(work_running[i]);
+
+    work_queues[i].head = work_queues[i].tail = 0;
+    work_running[i] = 0;
+    pthread_mutex_unlock(&work_queues[i].lock);
+  }
+
+  work_threads = 0;
+  work_sleepers = 0;
+  work_queued = 0;
+  work_once = once;
+
+  pthread_cond_init(&work_idle_cond, 0);
+  pthread_mutex_unlock(&work_idle_lock);
+}
+
+ecb_cold static void work_atfork_init(void) {
+  pthread_atfork(work_atfork_prepare, work_atfork_parent, work_atfork_child);
+}
+
+ecb_cold static void work_pool_init(void) {
+  int n = work_threads_wanted;
+  int i;
+
+  pthread_once(&work_atfork_once, work_atfork_init);
+
+  if (n <= 0)
+    n = (int)sysconf(_SC_NPROCESSORS_ONLN);
+
+  n = n < 1 ? 1 : n > EV_WORK_MAXTHREADS ? EV_WORK_MAXTHREADS : n;
+
+  for (i = 0; i < n; ++i)
+    pthread_mutex_init(&work_queues[i].lock, 0);
+
+  for (i = 0; i < n; ++i) {
+    pthread_t tid;
+    pthread_attr_t attr;
+
+    pthread_attr_init(&attr);
+    pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+
+    if (pthread_create(&tid, &attr, work_thread, (void*)(long)i)) {
+      pthread_attr_destroy(&attr);
+
+      if (!i)
+        ev_syserr("(libev) cannot start ev_work pool thread");
+
+      break;
+    }
+
+    pthread_attr_destroy(&attr);
+  }
+
+  /* threads only steal from queues below work_threads, submissions go there too */
+  ev_atomic_store(&work_threads, i);
+}
+
+inline_size void work_submit(ev_work* w) {
+  int n;
+
+  pthread_once(&work_once, work_pool_init);
+  n = ev_atomic_load(&work_threads);
+
+  work_push(&work_queues[ev_atomic_add(&work_next, 1) % n], w);
+  ev_atomic_add(&work_queued, 1);
+
+  pthread_mutex_lock(&work_idle_lock);
+
+  if (work_sleepers)
+    pthread_cond_signal(&work_idle_cond);
+
+  pthread_mutex_unlock(&work_idle_lock);
+}
+
+#endif
@@ -4,8 +4,16 @@
 #define acquire_cb ((loop)->acquire_cb)
 #define activecnt ((loop)->activecnt)
 #define activeio ((loop)->activeio)
+#define alloc_cb ((loop)->alloc_cb)
+#define alloc_ctx ((loop)->alloc_ctx)
+#define anfdcnts ((loop)->anfdcnts)
 #define anfdmax ((loop)->anfdmax)
+#define anfdpagemax ((loop)->anfdpagemax)
 #define anfds ((loop)->anfds)
+#define anfdxmax ((loop)->anfdxmax)
+#define anfdxs ((loop)->anfdxs)
+#define async_map ((loop)->async_map)
+#define async_mapsum ((loop)->async_mapsum)
 #define async_pending ((loop)->async_pending)
 #define asynccnt ((loop)->asynccnt)
 #define asyncmax ((loop)->asyncmax)
@@ -15,6 +23,7 @@
 #define backend_mintime ((loop)->backend_mintime)
 #define backend_modify ((loop)->backend_modify)
 #define backend_poll ((loop)->backend_poll)
+#define busy_polltime ((loop)->busy_polltime)
 #define checkcnt ((loop)->checkcnt)
 #define checkmax ((loop)->checkmax)
 #define checks ((loop)->checks)
@@ -22,15 +31,27 @@
 #define cleanupmax ((loop)->cleanupmax)
 #define cleanups ((loop)->cleanups)
 #define curpid ((loop)->curpid)
+#define defer_head ((loop)->defer_head)
+#define defer_limit ((loop)->defer_limit)
+#define defer_tail ((loop)->defer_tail)
+#define edf_active ((loop)->edf_active)
+#define edf_tracked ((loop)->edf_tracked)
+#define edfcnt ((loop)->edfcnt)
+#define edfmax ((loop)->edfmax)
+#define edfs ((loop)->edfs)
 #define epoll_epermcnt ((loop)->epoll_epermcnt)
 #define epoll_epermmax ((loop)->epoll_epermmax)
 #define epoll_eperms ((loop)->epoll_eperms)
 #define epoll_eventmax ((loop)->epoll_eventmax)
 #define epoll_events ((loop)->epoll_events)
 #define evpipe ((loop)->evpipe)
+#define fdbitmax ((loop)->fdbitmax)
+#define fdbits ((loop)->fdbits)
 #define fdchangecnt ((loop)->fdchangecnt)
 #define fdchangemax ((loop)->fdchangemax)
 #define fdchanges ((loop)->fdchanges)
+#define fdsummax ((loop)->fdsummax)
+#define fdsums ((loop)->fdsums)
 #define forkcnt ((loop)->forkcnt)
 #define forkmax ((loop)->forkmax)
 #define forks ((loop)->forks)
@@ -38,11 +59,20 @@
 #define fs_fd ((loop)->fs_fd)
 #define fs_hash ((loop)->fs_hash)
 #define fs_w ((loop)->fs_w)
+#define hotcnt ((loop)->hotcnt)
+#define hotmax ((loop)->hotmax)
+#define hotpolls ((loop)->hotpolls)
+#define hots ((loop)->hots)
 #define idleall ((loop)->idleall)
 #define idlecnt ((loop)->idlecnt)
 #define idlemax ((loop)->idlemax)
 #define idles ((loop)->idles)
+#define invoke_budget ((loop)->invoke_budget)
 #define invoke_cb ((loop)->invoke_cb)
+#define invoke_deferred ((loop)->invoke_deferred)
+#define invoke_leftover ((loop)->invoke_leftover)
+#define invoke_passes ((loop)->invoke_passes)
+#define invoke_timebudget ((loop)->invoke_timebudget)
 #define io_blocktime ((loop)->io_blocktime)
 #define iocp ((loop)->iocp)
 #define iouring_cq_cqes ((loop)->iouring_cq_cqes)
@@ -94,13 +124,20 @@
 #define loop_count ((loop)->loop_count)
 #define loop_depth ((loop)->loop_depth)
 #define loop_done ((loop)->loop_done)
+#define migrate_in ((loop)->migrate_in)
+#define migrate_pending ((loop)->migrate_pending)
+#define migrate_ready ((loop)->migrate_ready)
 #define mn_now ((loop)->mn_now)
 #define now_floor ((loop)->now_floor)
+#define once_free ((loop)->once_free)
+#define once_slabs ((loop)->once_slabs)
 #define origflags ((loop)->origflags)
 #define pending_w ((loop)->pending_w)
+#define pendingbits ((loop)->pendingbits)
 #define pendingcnt ((loop)->pendingcnt)
+#define pendingdlmax ((loop)->pendingdlmax)
+#define pendingdls ((loop)->pendingdls)
 #define pendingmax ((loop)->pendingmax)
-#define pendingpri ((loop)->pendingpri)
 #define pendings ((loop)->pendings)
 #define periodiccnt ((loop)->periodiccnt)
 #define periodicmax ((loop)->periodicmax)
@@ -119,7 +156,14 @@
 #define preparecnt ((loop)->preparecnt)
 #define preparemax ((loop)->preparemax)
 #define prepares ((loop)->prepares)
+#define pri_cursor ((loop)->pri_cursor)
+#define pri_deadline ((loop)->pri_deadline)
+#define pri_weight ((loop)->pri_weight)
+#define pri_weighted ((loop)->pri_weighted)
 #define release_cb ((loop)->release_cb)
+#define reserve_fds ((loop)->reserve_fds)
+#define reserve_pending ((loop)->reserve_pending)
+#define reserve_timers ((loop)->reserve_timers)
 #define rfeedcnt ((loop)->rfeedcnt)
 #define rfeedmax ((loop)->rfeedmax)
 #define rfeeds ((loop)->rfeeds)
@@ -141,13 +185,23 @@
 #define vec_ro ((loop)->vec_ro)
 #define vec_wi ((loop)->vec_wi)
 #define vec_wo ((loop)->vec_wo)
+#define work_completed ((loop)->work_completed)
+#define work_pending ((loop)->work_pending)
 #else
 #undef EV_WRAP_H
 #undef acquire_cb
 #undef activecnt
 #undef activeio
+#undef alloc_cb
+#undef alloc_ctx
+#undef anfdcnts
 #undef anfdmax
+#undef anfdpagemax
 #undef anfds
+#undef anfdxmax
+#undef anfdxs
+#undef async_map
+#undef async_mapsum
 #undef async_pending
 #undef asynccnt
 #undef asyncmax
@@ -157,6 +211,7 @@
 #undef backend_mintime
 #undef backend_modify
 #undef backend_poll
+#undef busy_polltime
 #undef checkcnt
 #undef checkmax
 #undef checks
@@ -164,15 +219,27 @@
 #undef cleanupmax
 #undef cleanups
 #undef curpid
+#undef defer_head
+#undef defer_limit
+#undef defer_tail
+#undef edf_active
+#undef edf_tracked
+#undef edfcnt
+#undef edfmax
+#undef edfs
 #undef epoll_epermcnt
 #undef epoll_epermmax
 #undef epoll_eperms
 #undef epoll_eventmax
 #undef epoll_events
 #undef evpipe
+#undef fdbitmax
+#undef fdbits
 #undef fdchangecnt
 #undef fdchangemax
 #undef fdchanges
+#undef fdsummax
+#undef fdsums
 #undef forkcnt
 #undef forkmax
 #undef forks
@@ -180,11 +247,20 @@
 #undef fs_fd
 #undef fs_hash
 #undef fs_w
+#undef hotcnt
+#undef hotmax
+#undef hotpolls
+#undef hots
 #undef idleall
 #undef idlecnt
 #undef idlemax
 #undef idles
+#undef invoke_budget
 #undef invoke_cb
+#undef invoke_deferred
+#undef invoke_leftover
+#undef invoke_passes
+#undef invoke_timebudget
 #undef io_blocktime
 #undef iocp
 #undef iouring_cq_cqes
@@ -234,13 +310,20 @@
 #undef loop_count
 #undef loop_depth
 #undef loop_done
+#undef migrate_in
+#undef migrate_pending
+#undef migrate_ready
 #undef mn_now
 #undef now_floor
+#undef once_free
+#undef once_slabs
 #undef origflags
 #undef pending_w
+#undef pendingbits
 #undef pendingcnt
+#undef pendingdlmax
+#undef pendingdls
 #undef pendingmax
-#undef pendingpri
 #undef pendings
 #undef periodiccnt
 #undef periodicmax
@@ -259,7 +342,14 @@
 #undef preparecnt
 #undef preparemax
 #undef prepares
+#undef pri_cursor
+#undef pri_deadline
+#undef pri_weight
+#undef pri_weighted
 #undef release_cb
+#undef reserve_fds
+#undef reserve_pending
+#undef reserve_timers
 #undef rfeedcnt
 #undef rfeedmax
 #undef rfeeds
@@ -281,4 +371,6 @@
 #undef vec_ro
 #undef vec_wi
 #undef vec_wo
+#undef work_completed
+#undef work_pending
 #endif
@@ -347,6 +347,7 @@ int event_base_loopexit(struct event_base* base, struct timeval* tv) {
 }
 
 struct ev_x_once {
+  ev_once_storage w;
   int fd;
   void (*cb)(int, short, void*);
   void* arg;
@@ -375,7 +376,7 @@ int event_base_once(struct event_base* base,
   once->cb = cb;
   once->arg = arg;
 
-  ev_once(EV_A_ fd, events & (EV_READ | EV_WRITE), ev_tv_get(tv), ev_x_once_cb, once);
+  ev_once_start(EV_A_ & once->w, fd, events & (EV_READ | EV_WRITE), ev_tv_get(tv), ev_x_once_cb, once);
 
   return 0;
 }
@@ -0,0 +1,158 @@
+#include <ev.h>
+#include <pthread.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include "perf_bench_common.h"
+
+/* socketpair ping-pong against an echo thread, round-trip latency with */
+/* a plain blocking loop and with ev_set_busy_poll spinning before it blocks */
+#define BUSY_POLL_BUDGET 50e-6
+
+static ev_io ping_io;
+static int target_pings;
+static int done_pings;
+static double* latencies;
+static struct timespec sent_at;
+
+static void* echo_thread(void* arg) {
+  int fd = (int)(long)arg;
+  char c;
+
+  while (read(fd, &c, 1) == 1)
+    if (write(fd, &c, 1) != 1)
+      break;
+
+  return 0;
+}
+
+static void ping_cb(EV_P_ ev_io* w, int revents) {
+  struct timespec now;
+  char c;
+
+  (void)revents;
+
+  if (read(ev_io_fd(w), &c, 1) != 1) {
+    return;
+  }
+
+  bench_clock_now(&now);
+  latencies[done_pings] = bench_elapsed_seconds(&sent_at, &now);
+
+  if (++done_pings == target_pings) {
+    ev_io_stop(EV_A_ w);
+    return;
+  }
+
+  bench_clock_now(&sent_at);
+
+  if (write(ev_io_fd(w), &c, 1) != 1) {
+    perror("write");
+  }
+}
+
+static int cmp_double(const void* a, const void* b) {
+  double x = *(const double*)a;
+  double y = *(const double*)b;
+
+  return x < y ? -1 : x > y;
+}
+
+static int run_ping_pong(int busy, double* seconds_out) {
+  struct ev_loop* loop = ev_loop_new(EVFLAG_AUTO);
+  struct timespec start;
+  struct timespec end;
+  pthread_t tid;
+  int fds[2];
+
+  if (!loop) {
+    fprintf(stderr, "failed to create ev loop\n");
+    return 1;
+  }
+
+  if (socketpair(AF_UNIX, SOCK_STREAM, 0, fds)) {
+    perror("socketpair");
+    ev_loop_destroy(loop);
+    return 2;
+  }
+
+  if (pthread_create(&tid, 0, echo_thread, (void*)(long)fds[1])) {
+    fprintf(stderr, "failed to start echo thread\n");
+    ev_loop_destroy(loop);
+    return 3;
+  }
+
+  ev_set_busy_poll(loop, busy ? BUSY_POLL_BUDGET : 0.);
+
+  done_pings = 0;
+  ev_io_init(&ping_io, ping_cb, fds[0], EV_READ);
+  ev_io_start(loop, &ping_io);
+
+  if (bench_clock_now(&start) != 0) {
+    perror("clock_gettime(START)");
+    return 4;
+  }
+
+  sent_at = start;
+
+  if (write(fds[0], "x", 1) != 1) {
+    perror("write");
+    return 5;
+  }
+
+  ev_run(loop, 0);
+
+  if (bench_clock_now(&end) != 0) {
+    perror("clock_gettime(END)");
+    return 6;
+  }
+
+  /* closing our end makes the echo thread's read return 0 */
+  close(fds[0]);
+  pthread_join(tid, 0);
+  close(fds[1]);
+  ev_loop_destroy(loop);
+
+  *seconds_out = bench_elapsed_seconds(&start, &end);
+
+  return 0;
+}
+
+int main(void) {
+  const int iterations = bench_read_iterations();
+  const int runs = bench_read_runs();
+
+  /* every ping is two thread handoffs */
+  target_pings = iterations / 10 > 100 ? iterations / 10 : 100;
+  latencies = (double*)malloc(sizeof(double) * target_pings);
+
+  if (!latencies) {
+    return 1;
+  }
+
+  for (int busy = 0; busy < 2; ++busy) {
+    double total_seconds = 0.0;
+
+    for (int i = 0; i < runs; ++i) {
+      double seconds = 0.0;
+      int rc = run_ping_pong(busy, &seconds);
+
+      if (rc != 0) {
+        return rc;
+      }
+
+      total_seconds += seconds;
+    }
+
+    bench_print_result(busy ? "ping-pong-busy-poll" : "ping-pong-blocking", target_pings, total_seconds / runs,
+                       ev_version_major(), ev_version_minor(), runs);
+
+    /* percentiles of the last run */
+    qsort(latencies, target_pings, sizeof(double), cmp_double);
+    printf("scenario=%s p50_us=%.2f p99_us=%.2f max_us=%.2f\n", busy ? "busy-poll-latency" : "blocking-latency",
+           latencies[target_pings / 2] * 1e6, latencies[(int)(target_pings * 0.99)] * 1e6,
+           latencies[target_pings - 1] * 1e6);
+  }
+
+  free(latencies);
+  return 0;
+}
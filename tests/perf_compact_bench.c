@@ -0,0 +1,99 @@
+/* embeds the library, so the same source measures the default and the */
+/* EV_COMPACT watcher layout (built with -DEV_COMPACT=2) */
+#include "ev.c"
+#include "perf_bench_common.h"
+
+/* many io watchers sharing few fds, as with a huge number of mostly idle */
+/* connections: fd_event walks the watcher lists, the callbacks touch each */
+/* watcher again, so the cost follows the bytes per watcher */
+#define WATCHERS (1 << 20)
+#define FDS 64
+
+static ev_io* watchers;
+static long invoked;
+
+static void io_cb(EV_P_ ev_io* w, int revents) {
+  (void)loop;
+  (void)w;
+  (void)revents;
+
+  ++invoked;
+}
+
+static int run_fanout_bench(struct ev_loop* loop, int target, double* seconds_out) {
+  struct timespec start;
+  struct timespec end;
+
+  invoked = 0;
+
+  if (bench_clock_now(&start) != 0) {
+    perror("clock_gettime(START)");
+    return 1;
+  }
+
+  for (int n = 0; n < target; ++n) {
+    ev_feed_fd_event(loop, n % FDS, EV_READ);
+
+    if (n % FDS == FDS - 1) {
+      ev_invoke_pending(loop);
+    }
+  }
+
+  ev_invoke_pending(loop);
+
+  if (bench_clock_now(&end) != 0) {
+    perror("clock_gettime(END)");
+    return 2;
+  }
+
+  if (invoked != (long)target * (WATCHERS / FDS)) {
+    fprintf(stderr, "lost io callbacks\n");
+    return 3;
+  }
+
+  *seconds_out = bench_elapsed_seconds(&start, &end);
+
+  return 0;
+}
+
+int main(void) {
+  const int iterations = bench_read_iterations();
+  const int runs = bench_read_runs();
+  const int target = iterations / 1000 > FDS ? iterations / 1000 : FDS;
+  double total_seconds = 0.0;
+  struct ev_loop* loop = ev_loop_new(EVFLAG_AUTO);
+
+  watchers = (ev_io*)malloc(sizeof(ev_io) * WATCHERS);
+
+  if (!loop || !watchers) {
+    fprintf(stderr, "failed to create ev loop\n");
+    return 1;
+  }
+
+  /* the loop never runs, so these fds are never polled */
+  for (int i = 0; i < WATCHERS; ++i) {
+    ev_io_init(&watchers[i], io_cb, i % FDS, EV_READ);
+    ev_io_start(loop, &watchers[i]);
+  }
+
+  for (int r = 0; r < runs; ++r) {
+    double seconds = 0.0;
+    int rc = run_fanout_bench(loop, target, &seconds);
+
+    if (rc != 0) {
+      return rc;
+    }
+
+    total_seconds += seconds;
+  }
+
+  bench_print_result(EV_COMPACT ? "io-fanout-compact" : "io-fanout", target, total_seconds / runs,
+                     ev_version_major(), ev_version_minor(), runs);
+  printf("scenario=%s io_bytes=%d timer_bytes=%d watchers_mb=%.1f\n", EV_COMPACT ? "compact" : "default",
+         (int)sizeof(ev_io), (int)sizeof(ev_timer), sizeof(ev_io) * (double)WATCHERS / (1 << 20));
+
+  ev_loop_destroy(loop);
+  free(watchers);
+
+  return 0;
+}
@@ -0,0 +1,116 @@
+#include <ev.h>
+#include "perf_bench_common.h"
+
+/* "run this after the current callback": every invocation of a fed watcher */
+/* asks for one follow-up call, made either through an ev_check watcher that */
+/* starts and stops itself, or through an ev_defer */
+#define BATCH 64
+
+static ev_idle sources[BATCH];
+static ev_check checks[BATCH];
+static ev_defer defers[BATCH];
+static int use_defer;
+static int followups;
+
+static void check_cb(EV_P_ ev_check* w, int revents) {
+  (void)revents;
+
+  ev_check_stop(EV_A_ w);
+  ++followups;
+}
+
+static void defer_cb(EV_P_ ev_defer* d) {
+  (void)loop;
+  (void)d;
+
+  ++followups;
+}
+
+static void source_cb(EV_P_ ev_idle* w, int revents) {
+  int i = (int)(w - sources);
+
+  (void)revents;
+
+  if (use_defer) {
+    ev_defer_call(EV_A_ & defers[i]);
+  } else {
+    ev_check_start(EV_A_ & checks[i]);
+  }
+}
+
+static int run_followup_bench(int rounds, double* seconds_out) {
+  struct ev_loop* loop = ev_loop_new(EVFLAG_AUTO);
+  struct timespec start;
+  struct timespec end;
+
+  if (!loop) {
+    fprintf(stderr, "failed to create ev loop\n");
+    return 1;
+  }
+
+  for (int i = 0; i < BATCH; ++i) {
+    ev_idle_init(&sources[i], source_cb);
+    ev_check_init(&checks[i], check_cb);
+    ev_defer_init(&defers[i], defer_cb);
+  }
+
+  followups = 0;
+
+  if (bench_clock_now(&start) != 0) {
+    perror("clock_gettime(START)");
+    ev_loop_destroy(loop);
+    return 2;
+  }
+
+  for (int r = 0; r < rounds; ++r) {
+    for (int i = 0; i < BATCH; ++i) {
+      ev_feed_event(loop, &sources[i], EV_CUSTOM);
+    }
+
+    /* one loop iteration makes the check calls, ev_invoke_pending the deferred ones */
+    ev_run(loop, EVRUN_NOWAIT);
+  }
+
+  if (bench_clock_now(&end) != 0) {
+    perror("clock_gettime(END)");
+    ev_loop_destroy(loop);
+    return 3;
+  }
+
+  ev_loop_destroy(loop);
+
+  if (followups != rounds * BATCH) {
+    fprintf(stderr, "lost follow-up calls\n");
+    return 4;
+  }
+
+  *seconds_out = bench_elapsed_seconds(&start, &end);
+
+  return 0;
+}
+
+int main(void) {
+  const int iterations = bench_read_iterations();
+  const int runs = bench_read_runs();
+  const int rounds = iterations / BATCH > 1 ? iterations / BATCH : 1;
+
+  for (use_defer = 0; use_defer < 2; ++use_defer) {
+    double total_seconds = 0.0;
+
+    for (int i = 0; i < runs; ++i) {
+      double seconds = 0.0;
+      int rc = run_followup_bench(rounds, &seconds);
+
+      if (rc != 0) {
+        return rc;
+      }
+
+      total_seconds += seconds;
+    }
+
+    bench_print_result(use_defer ? "followup-defer" : "followup-check", rounds * BATCH, total_seconds / runs,
+                       ev_version_major(), ev_version_minor(), runs);
+  }
+
+  return 0;
+}
@@ -0,0 +1,138 @@
+#include <ev.h>
+#include "perf_bench_common.h"
+
+/* mixed load: every round queues a burst of bulk callbacks and one latency-tagged */
+/* callback that became ready first, and measures how long the tagged one waits */
+/* with the default lifo dispatch and with earliest-deadline-first dispatch */
+#define BULK 256
+#define BULK_WORK 200
+#define TAGGED_BUDGET 100e-6
+
+static ev_idle bulk[BULK];
+static ev_idle tagged;
+static double* latencies;
+static int rounds;
+static int done_rounds;
+static struct timespec round_start;
+
+static void bulk_cb(EV_P_ ev_idle* w, int revents) {
+  volatile int sink = 0;
+
+  (void)loop;
+  (void)w;
+  (void)revents;
+
+  for (int i = 0; i < BULK_WORK; ++i) {
+    sink += i;
+  }
+}
+
+static void tagged_cb(EV_P_ ev_idle* w, int revents) {
+  struct timespec now;
+
+  (void)loop;
+  (void)w;
+  (void)revents;
+
+  bench_clock_now(&now);
+  latencies[done_rounds] = bench_elapsed_seconds(&round_start, &now);
+}
+
+static int cmp_double(const void* a, const void* b) {
+  double x = *(const double*)a;
+  double y = *(const double*)b;
+
+  return x < y ? -1 : x > y;
+}
+
+static int run_mixed_bench(int edf, double* seconds_out) {
+  struct ev_loop* loop = ev_loop_new(EVFLAG_AUTO);
+  struct timespec start;
+  struct timespec end;
+
+  if (!loop) {
+    fprintf(stderr, "failed to create ev loop\n");
+    return 1;
+  }
+
+  /* bulk work may wait, tagged work carries its own much tighter deadline */
+  if (edf) {
+    ev_set_priority_deadline(loop, 0, 10e-3);
+  }
+
+  ev_idle_init(&tagged, tagged_cb);
+
+  for (int i = 0; i < BULK; ++i) {
+    ev_idle_init(&bulk[i], bulk_cb);
+  }
+
+  if (bench_clock_now(&start) != 0) {
+    perror("clock_gettime(START)");
+    ev_loop_destroy(loop);
+    return 2;
+  }
+
+  for (done_rounds = 0; done_rounds < rounds; ++done_rounds) {
+    bench_clock_now(&round_start);
+    ev_now_update(loop);
+
+    ev_feed_event_deadline(loop, &tagged, EV_CUSTOM, ev_now(loop) + TAGGED_BUDGET);
+
+    for (int i = 0; i < BULK; ++i) {
+      ev_feed_event(loop, &bulk[i], EV_CUSTOM);
+    }
+
+    ev_invoke_pending(loop);
+  }
+
+  if (bench_clock_now(&end) != 0) {
+    perror("clock_gettime(END)");
+    ev_loop_destroy(loop);
+    return 3;
+  }
+
+  ev_loop_destroy(loop);
+
+  *seconds_out = bench_elapsed_seconds(&start, &end);
+
+  return 0;
+}
+
+int main(void) {
+  const int iterations = bench_read_iterations();
+  const int runs = bench_read_runs();
+
+  /* iterations counts callbacks */
+  rounds = iterations / BULK > 10 ? iterations / BULK : 10;
+  latencies = (double*)malloc(sizeof(double) * rounds);
+
+  if (!latencies) {
+    return 1;
+  }
+
+  for (int edf = 0; edf < 2; ++edf) {
+    double total_seconds = 0.0;
+
+    for (int i = 0; i < runs; ++i) {
+      double seconds = 0.0;
+      int rc = run_mixed_bench(edf, &seconds);
+
+      if (rc != 0) {
+        return rc;
+      }
+
+      total_seconds += seconds;
+    }
+
+    bench_print_result(edf ? "mixed-edf" : "mixed-lifo", rounds * (BULK + 1), total_seconds / runs, ev_version_major(),
+                       ev_version_minor(), runs);
+
+    /* percentiles of the last run */
+    qsort(latencies, rounds, sizeof(double), cmp_double);
+    printf("scenario=%s p50_us=%.2f p99_us=%.2f max_us=%.2f\n", edf ? "edf-tagged-latency" : "lifo-tagged-latency",
+           latencies[rounds / 2] * 1e6, latencies[(int)(rounds * 0.99)] * 1e6, latencies[rounds - 1] * 1e6);
+  }
+
+  free(latencies);
+  return 0;
+}
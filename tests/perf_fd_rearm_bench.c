@@ -0,0 +1,115 @@
+#include <ev.h>
+#include <sys/resource.h>
+#include <unistd.h>
+#include "perf_bench_common.h"
+
+/* ev_loop_fork with a handful of watchers on fds spread up to the fd limit: */
+/* re-arming after a fork should cost per watched fd, not per possible fd */
+#define FDS 8
+
+static ev_io ios[FDS];
+
+static void never_cb(EV_P_ ev_io* w, int revents) {
+  (void)loop;
+  (void)w;
+  (void)revents;
+}
+
+static int run_rearm_bench(int high, int target, double* seconds_out) {
+  /* epoll has to rebuild its kernel state after a fork */
+  struct ev_loop* loop = ev_loop_new(EVBACKEND_EPOLL);
+  struct timespec start;
+  struct timespec end;
+  int p[2];
+
+  if (!loop) {
+    loop = ev_loop_new(EVFLAG_AUTO);
+  }
+
+  if (!loop) {
+    fprintf(stderr, "failed to create ev loop\n");
+    return 1;
+  }
+
+  if (pipe(p)) {
+    perror("pipe");
+    return 2;
+  }
+
+  for (int i = 0; i < FDS; ++i) {
+    int fd = high - i * (high / FDS);
+
+    if (dup2(p[0], fd) != fd) {
+      perror("dup2");
+      return 3;
+    }
+
+    ev_io_init(&ios[i], never_cb, fd, EV_READ);
+    ev_io_start(loop, &ios[i]);
+  }
+
+  ev_run(loop, EVRUN_NOWAIT);
+
+  if (bench_clock_now(&start) != 0) {
+    perror("clock_gettime(START)");
+    return 4;
+  }
+
+  for (int i = 0; i < target; ++i) {
+    ev_loop_fork(loop);
+    ev_run(loop, EVRUN_NOWAIT);
+  }
+
+  if (bench_clock_now(&end) != 0) {
+    perror("clock_gettime(END)");
+    return 5;
+  }
+
+  for (int i = 0; i < FDS; ++i) {
+    ev_io_stop(loop, &ios[i]);
+    close(ev_io_fd(&ios[i]));
+  }
+
+  close(p[0]);
+  close(p[1]);
+  ev_loop_destroy(loop);
+
+  *seconds_out = bench_elapsed_seconds(&start, &end);
+
+  return 0;
+}
+
+int main(void) {
+  const int iterations = bench_read_iterations();
+  const int runs = bench_read_runs();
+  const int target = iterations / 10 > 1 ? iterations / 10 : 1;
+  double total_seconds = 0.0;
+  struct rlimit rl;
+  int high;
+
+  if (getrlimit(RLIMIT_NOFILE, &rl)) {
+    return 1;
+  }
+
+  rl.rlim_cur = rl.rlim_max;
+  setrlimit(RLIMIT_NOFILE, &rl);
+  getrlimit(RLIMIT_NOFILE, &rl);
+
+  high = rl.rlim_cur > 1000000 ? 999999 : (int)rl.rlim_cur - 1;
+
+  for (int i = 0; i < runs; ++i) {
+    double seconds = 0.0;
+    int rc = run_rearm_bench(high, target, &seconds);
+
+    if (rc != 0) {
+      return rc;
+    }
+
+    total_seconds += seconds;
+  }
+
+  bench_print_result("fd-rearm-sparse", target, total_seconds / runs, ev_version_major(), ev_version_minor(), runs);
+  printf("scenario=fd-rearm-sparse watched=%d highest_fd=%d\n", FDS, high);
+
+  return 0;
+}
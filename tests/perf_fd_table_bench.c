@@ -0,0 +1,127 @@
+#include <ev.h>
+#include <sys/eventfd.h>
+#include <sys/resource.h>
+#include <unistd.h>
+#include "perf_bench_common.h"
+
+/* event dispatch over a large fd table: up to 100k always-readable fds, */
+/* each kernel event goes through the per-fd table in epoll_poll and fd_event */
+#define MAX_FDS 100000
+
+static ev_io* ios;
+static long events;
+
+static void ready_cb(EV_P_ ev_io* w, int revents) {
+  (void)loop;
+  (void)w;
+  (void)revents;
+
+  ++events;
+}
+
+/* as many fds as the limits allow, up to MAX_FDS */
+static int open_fds(void) {
+  struct rlimit rl;
+  int n = MAX_FDS;
+
+  if (!getrlimit(RLIMIT_NOFILE, &rl)) {
+    rl.rlim_cur = rl.rlim_max;
+    setrlimit(RLIMIT_NOFILE, &rl);
+    getrlimit(RLIMIT_NOFILE, &rl);
+
+    if (rl.rlim_cur < (rlim_t)n + 64) {
+      n = (int)rl.rlim_cur - 64;
+    }
+  }
+
+  return n;
+}
+
+static int run_table_bench(int fds, long target, double* seconds_out) {
+  struct ev_loop* loop = ev_loop_new(EVBACKEND_EPOLL);
+  struct timespec start;
+  struct timespec end;
+  int opened = 0;
+
+  if (!loop) {
+    loop = ev_loop_new(EVFLAG_AUTO);
+  }
+
+  if (!loop) {
+    fprintf(stderr, "failed to create ev loop\n");
+    return 1;
+  }
+
+  for (; opened < fds; ++opened) {
+    int fd = eventfd(1, EFD_NONBLOCK);
+
+    if (fd < 0) {
+      perror("eventfd");
+      return 2;
+    }
+
+    ev_io_init(&ios[opened], ready_cb, fd, EV_READ);
+    ev_io_start(loop, &ios[opened]);
+  }
+
+  /* registers everything with the kernel */
+  ev_run(loop, EVRUN_NOWAIT);
+  events = 0;
+
+  if (bench_clock_now(&start) != 0) {
+    perror("clock_gettime(START)");
+    return 3;
+  }
+
+  while (events < target) {
+    ev_run(loop, EVRUN_ONCE);
+  }
+
+  if (bench_clock_now(&end) != 0) {
+    perror("clock_gettime(END)");
+    return 4;
+  }
+
+  for (int i = 0; i < opened; ++i) {
+    ev_io_stop(loop, &ios[i]);
+    close(ev_io_fd(&ios[i]));
+  }
+
+  ev_loop_destroy(loop);
+
+  *seconds_out = bench_elapsed_seconds(&start, &end);
+
+  return 0;
+}
+
+int main(void) {
+  const int iterations = bench_read_iterations();
+  const int runs = bench_read_runs();
+  const int fds = open_fds();
+  const long target = (long)iterations * 10;
+  double total_seconds = 0.0;
+
+  ios = (ev_io*)calloc(fds, sizeof(ev_io));
+
+  if (!ios || fds <= 0) {
+    return 1;
+  }
+
+  for (int i = 0; i < runs; ++i) {
+    double seconds = 0.0;
+    int rc = run_table_bench(fds, target, &seconds);
+
+    if (rc != 0) {
+      return rc;
+    }
+
+    total_seconds += seconds;
+  }
+
+  bench_print_result("fd-table-events", (int)target, total_seconds / runs, ev_version_major(), ev_version_minor(),
+                     runs);
+  printf("scenario=fd-table-events fds=%d events_per_second=%.0f\n", fds, target / (total_seconds / runs));
+
+  free(ios);
+  return 0;
+}
@@ -0,0 +1,183 @@
+#include <ev.h>
+#include <string.h>
+#include <unistd.h>
+#include "perf_bench_common.h"
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#endif
+
+/* random access into a large timer heap (downheap on ev_timer_again) and a */
+/* large fd table (fd_event on ev_feed_fd_event), with and without */
+/* EVFLAG_HUGEPAGES | EVFLAG_NUMALOCAL, counting dTLB misses where allowed */
+#define TIMERS (1 << 19)
+#define FDS (1 << 20)
+
+static ev_timer timers[TIMERS];
+
+static void never_cb(EV_P_ ev_timer* w, int revents) {
+  (void)loop;
+  (void)w;
+  (void)revents;
+}
+
+/* -1 when there are no (permitted) hardware counters */
+static int dtlb_open(void) {
+#ifdef __linux__
+  struct perf_event_attr attr;
+
+  memset(&attr, 0, sizeof(attr));
+  attr.size = sizeof(attr);
+  attr.type = PERF_TYPE_HW_CACHE;
+  attr.config = PERF_COUNT_HW_CACHE_DTLB | (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+                (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+  attr.disabled = 1;
+  attr.exclude_kernel = 1;
+  attr.exclude_hv = 1;
+
+  return (int)syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+#else
+  return -1;
+#endif
+}
+
+static void dtlb_start(int fd) {
+#ifdef __linux__
+  if (fd >= 0) {
+    ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+    ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+  }
+#else
+  (void)fd;
+#endif
+}
+
+static long long dtlb_stop(int fd) {
+  long long count = -1;
+
+#ifdef __linux__
+  if (fd >= 0) {
+    ioctl(fd, PERF_EVENT_IOC_DISABLE, 0);
+
+    if (read(fd, &count, sizeof(count)) != sizeof(count)) {
+      count = -1;
+    }
+  }
+#else
+  (void)fd;
+#endif
+
+  return count;
+}
+
+static unsigned int next_random(unsigned int* state) {
+  *state = *state * 1103515245u + 12345u;
+  return *state >> 8;
+}
+
+static int run_bench(unsigned int flags, int target, int dtlb, double* heap_seconds, double* fd_seconds,
+                     long long* heap_misses, long long* fd_misses) {
+  struct ev_loop* loop = ev_loop_new(flags);
+  unsigned int state = 1;
+  struct timespec start;
+  struct timespec end;
+
+  if (!loop) {
+    fprintf(stderr, "failed to create ev loop\n");
+    return 1;
+  }
+
+  ev_loop_reserve(loop, FDS, TIMERS, 0);
+
+  for (int i = 0; i < TIMERS; ++i) {
+    ev_timer_init(&timers[i], never_cb, 0., 3600. + (next_random(&state) & 0xffff));
+    ev_timer_start(loop, &timers[i]);
+  }
+
+  /* pushing random timers later makes them sink through the heap */
+  bench_clock_now(&start);
+  dtlb_start(dtlb);
+
+  for (int n = 0; n < target; ++n) {
+    ev_timer* w = &timers[next_random(&state) % TIMERS];
+
+    w->repeat += 1.;
+    ev_timer_again(loop, w);
+  }
+
+  *heap_misses = dtlb_stop(dtlb);
+  bench_clock_now(&end);
+  *heap_seconds = bench_elapsed_seconds(&start, &end);
+
+  /* events on random unwatched fds only look at their anfd */
+  bench_clock_now(&start);
+  dtlb_start(dtlb);
+
+  for (int n = 0; n < target; ++n) {
+    ev_feed_fd_event(loop, next_random(&state) % FDS, EV_READ);
+  }
+
+  *fd_misses = dtlb_stop(dtlb);
+  bench_clock_now(&end);
+  *fd_seconds = bench_elapsed_seconds(&start, &end);
+
+  for (int i = 0; i < TIMERS; ++i) {
+    ev_timer_stop(loop, &timers[i]);
+  }
+
+  ev_loop_destroy(loop);
+
+  return 0;
+}
+
+int main(void) {
+  const int iterations = bench_read_iterations();
+  const int runs = bench_read_runs();
+  const int target = iterations * 10;
+  const int dtlb = dtlb_open();
+
+  for (int huge = 0; huge < 2; ++huge) {
+    unsigned int flags = huge ? EVFLAG_HUGEPAGES | EVFLAG_NUMALOCAL : EVFLAG_AUTO;
+    double heap_total = 0.0;
+    double fd_total = 0.0;
+    long long heap_misses = 0;
+    long long fd_misses = 0;
+
+    for (int r = 0; r < runs; ++r) {
+      double heap_seconds;
+      double fd_seconds;
+      long long heap_run;
+      long long fd_run;
+      int rc = run_bench(flags, target, dtlb, &heap_seconds, &fd_seconds, &heap_run, &fd_run);
+
+      if (rc != 0) {
+        return rc;
+      }
+
+      heap_total += heap_seconds;
+      fd_total += fd_seconds;
+      heap_misses = heap_run < 0 || heap_misses < 0 ? -1 : heap_misses + heap_run;
+      fd_misses = fd_run < 0 || fd_misses < 0 ? -1 : fd_misses + fd_run;
+    }
+
+    bench_print_result(huge ? "timer-downheap-hugepages" : "timer-downheap", target, heap_total / runs,
+                       ev_version_major(), ev_version_minor(), runs);
+    bench_print_result(huge ? "fd-event-hugepages" : "fd-event", target, fd_total / runs, ev_version_major(),
+                       ev_version_minor(), runs);
+
+    if (heap_misses < 0 || fd_misses < 0) {
+      printf("scenario=%s dtlb_misses=unavailable\n", huge ? "hugepages" : "default");
+    } else {
+      printf("scenario=%s dtlb_misses_downheap=%lld dtlb_misses_fd_event=%lld\n", huge ? "hugepages" : "default",
+             heap_misses / runs, fd_misses / runs);
+    }
+  }
+
+  if (dtlb >= 0) {
+    close(dtlb);
+  }
+
+  return 0;
+}
@@ -0,0 +1,104 @@
+#include <ev.h>
+#include <unistd.h>
+#include "perf_bench_common.h"
+
+/* multiplexed streams: many read and write watchers share each fd, and one */
+/* of them is stopped and restarted per fd and loop iteration, so every */
+/* iteration reifies all fds with long watcher lists */
+#define FDS 16
+#define WATCHERS_PER_FD 256
+
+static ev_io ios[FDS][WATCHERS_PER_FD];
+static int pipes[FDS][2];
+
+static void never_cb(EV_P_ ev_io* w, int revents) {
+  (void)loop;
+  (void)w;
+  (void)revents;
+}
+
+static int run_churn_bench(int target, double* seconds_out) {
+  struct ev_loop* loop = ev_loop_new(EVFLAG_AUTO);
+  struct timespec start;
+  struct timespec end;
+
+  if (!loop) {
+    fprintf(stderr, "failed to create ev loop\n");
+    return 1;
+  }
+
+  /* the read end of an empty pipe is neither readable nor writable */
+  for (int i = 0; i < FDS; ++i) {
+    if (pipe(pipes[i])) {
+      perror("pipe");
+      return 2;
+    }
+
+    for (int j = 0; j < WATCHERS_PER_FD; ++j) {
+      ev_io_init(&ios[i][j], never_cb, pipes[i][0], j & 1 ? EV_WRITE : EV_READ);
+      ev_io_start(loop, &ios[i][j]);
+    }
+  }
+
+  ev_run(loop, EVRUN_NOWAIT);
+
+  if (bench_clock_now(&start) != 0) {
+    perror("clock_gettime(START)");
+    return 3;
+  }
+
+  for (int n = 0; n < target; ++n) {
+    for (int i = 0; i < FDS; ++i) {
+      ev_io* w = &ios[i][n % WATCHERS_PER_FD];
+
+      ev_io_stop(loop, w);
+      ev_io_start(loop, w);
+    }
+
+    ev_run(loop, EVRUN_NOWAIT);
+  }
+
+  if (bench_clock_now(&end) != 0) {
+    perror("clock_gettime(END)");
+    return 4;
+  }
+
+  for (int i = 0; i < FDS; ++i) {
+    for (int j = 0; j < WATCHERS_PER_FD; ++j) {
+      ev_io_stop(loop, &ios[i][j]);
+    }
+
+    close(pipes[i][0]);
+    close(pipes[i][1]);
+  }
+
+  ev_loop_destroy(loop);
+
+  *seconds_out = bench_elapsed_seconds(&start, &end);
+
+  return 0;
+}
+
+int main(void) {
+  const int iterations = bench_read_iterations();
+  const int runs = bench_read_runs();
+  const int target = iterations / 10 > 1 ? iterations / 10 : 1;
+  double total_seconds = 0.0;
+
+  for (int i = 0; i < runs; ++i) {
+    double seconds = 0.0;
+    int rc = run_churn_bench(target, &seconds);
+
+    if (rc != 0) {
+      return rc;
+    }
+
+    total_seconds += seconds;
+  }
+
+  bench_print_result("io-churn-shared-fds", target, total_seconds / runs, ev_version_major(), ev_version_minor(),
+                     runs);
+  printf("scenario=io-churn-shared-fds fds=%d watchers_per_fd=%d\n", FDS, WATCHERS_PER_FD);
+
+  return 0;
+}
@@ -0,0 +1,159 @@
+#include <ev.h>
+#include <pthread.h>
+#include <unistd.h>
+#include "perf_bench_common.h"
+
+/* an always-readable fd bounces between two loops on two threads, */
+/* every hop measures the time from ev_io_migrate to the callback in the target */
+
+static struct ev_loop* loops[2];
+static ev_async stop_watchers[2];
+static ev_io bouncer;
+static int target_hops;
+static int hops;
+static double* latencies;
+static struct timespec migrated_at;
+
+static double elapsed_since(const struct timespec* then) {
+  struct timespec now;
+
+  bench_clock_now(&now);
+  return bench_elapsed_seconds(then, &now);
+}
+
+static void stop_cb(EV_P_ ev_async* w, int revents) {
+  (void)w;
+  (void)revents;
+
+  ev_break(EV_A_ EVBREAK_ALL);
+}
+
+static void bounce_cb(EV_P_ ev_io* w, int revents) {
+  struct ev_loop* other = EV_A == loops[0] ? loops[1] : loops[0];
+
+  (void)revents;
+
+  if (hops)
+    latencies[hops - 1] = elapsed_since(&migrated_at);
+
+  if (++hops > target_hops) {
+    ev_io_stop(EV_A_ w);
+    ev_async_send(other, &stop_watchers[other == loops[1]]);
+    ev_break(EV_A_ EVBREAK_ALL);
+    return;
+  }
+
+  bench_clock_now(&migrated_at);
+
+  if (ev_io_migrate(EV_A_ ev_io_fd(w), other) != 1) {
+    fprintf(stderr, "ev_io_migrate failed\n");
+    exit(1);
+  }
+}
+
+static void* second_loop(void* arg) {
+  (void)arg;
+
+  ev_run(loops[1], 0);
+  return 0;
+}
+
+static int cmp_double(const void* a, const void* b) {
+  double x = *(const double*)a;
+  double y = *(const double*)b;
+
+  return x < y ? -1 : x > y;
+}
+
+static int run_migrate_bench(double* seconds_out) {
+  struct timespec start;
+  struct timespec end;
+  pthread_t tid;
+  int fds[2];
+  int i;
+
+  if (pipe(fds) || write(fds[1], "x", 1) != 1) {
+    perror("pipe");
+    return 1;
+  }
+
+  for (i = 0; i < 2; ++i) {
+    loops[i] = ev_loop_new(EVFLAG_AUTO);
+
+    if (!loops[i]) {
+      fprintf(stderr, "failed to create ev loop\n");
+      return 2;
+    }
+
+    /* also gives each loop the wakeup pipe migrations arrive through */
+    ev_async_init(&stop_watchers[i], stop_cb);
+    ev_async_start(loops[i], &stop_watchers[i]);
+  }
+
+  hops = 0;
+  ev_io_init(&bouncer, bounce_cb, fds[0], EV_READ);
+  ev_io_start(loops[0], &bouncer);
+
+  if (bench_clock_now(&start) != 0) {
+    perror("clock_gettime(START)");
+    return 3;
+  }
+
+  if (pthread_create(&tid, 0, second_loop, 0)) {
+    perror("pthread_create");
+    return 4;
+  }
+
+  ev_run(loops[0], 0);
+  pthread_join(tid, 0);
+
+  if (bench_clock_now(&end) != 0) {
+    perror("clock_gettime(END)");
+    return 5;
+  }
+
+  for (i = 0; i < 2; ++i)
+    ev_loop_destroy(loops[i]);
+
+  close(fds[0]);
+  close(fds[1]);
+
+  *seconds_out = bench_elapsed_seconds(&start, &end);
+
+  return 0;
+}
+
+int main(void) {
+  const int iterations = bench_read_iterations();
+  const int runs = bench_read_runs();
+  double total_seconds = 0.0;
+
+  /* a hop includes a cross-thread wakeup, far more than a plain iteration */
+  target_hops = iterations / 10 > 0 ? iterations / 10 : 1;
+  latencies = (double*)malloc(sizeof(double) * target_hops);
+
+  if (!latencies) {
+    return 1;
+  }
+
+  for (int i = 0; i < runs; ++i) {
+    double seconds = 0.0;
+    int rc = run_migrate_bench(&seconds);
+
+    if (rc != 0) {
+      return rc;
+    }
+
+    total_seconds += seconds;
+  }
+
+  /* percentiles of the last run */
+  qsort(latencies, target_hops, sizeof(double), cmp_double);
+
+  bench_print_result("io-migrate", target_hops, total_seconds / runs, ev_version_major(), ev_version_minor(), runs);
+  printf("scenario=io-migrate-latency p50_us=%.2f p99_us=%.2f max_us=%.2f\n", latencies[target_hops / 2] * 1e6,
+         latencies[(int)(target_hops * 0.99)] * 1e6, latencies[target_hops - 1] * 1e6);
+
+  free(latencies);
+  return 0;
+}
@@ -0,0 +1,122 @@
+#include <ev.h>
+#include <string.h>
+#include "perf_bench_common.h"
+
+/* short-lived loops that grow a timer heap: default allocator against a */
+/* bump arena handed to ev_loop_new_with_allocator and reset per loop */
+#define TIMERS 1024
+#define ARENA_SIZE (4 << 20)
+
+typedef struct {
+  char* base;
+  long used;
+} arena;
+
+static ev_timer timers[TIMERS];
+
+static void* arena_alloc(void* ptr, long size, void* ctx) {
+  arena* a = (arena*)ctx;
+  long* block;
+
+  if (!size) {
+    return 0; /* everything goes away with the arena */
+  }
+
+  block = (long*)(a->base + a->used);
+  a->used += (size + sizeof(long) + 15) & ~15L;
+
+  if (a->used > ARENA_SIZE) {
+    return 0;
+  }
+
+  *block = size;
+
+  if (ptr) {
+    memcpy(block + 1, ptr, ((long*)ptr)[-1] < size ? ((long*)ptr)[-1] : size);
+  }
+
+  return block + 1;
+}
+
+static void timer_cb(EV_P_ ev_timer* w, int revents) {
+  (void)loop;
+  (void)w;
+  (void)revents;
+}
+
+static int run_loop_lifecycle(arena* a) {
+  struct ev_loop* loop = a ? ev_loop_new_with_allocator(EVFLAG_AUTO, arena_alloc, a) : ev_loop_new(EVFLAG_AUTO);
+
+  if (!loop) {
+    fprintf(stderr, "failed to create ev loop\n");
+    return 1;
+  }
+
+  for (int i = 0; i < TIMERS; ++i) {
+    ev_timer_init(&timers[i], timer_cb, 3600. + i, 0.);
+    ev_timer_start(loop, &timers[i]);
+  }
+
+  ev_run(loop, EVRUN_NOWAIT);
+
+  for (int i = 0; i < TIMERS; ++i) {
+    ev_timer_stop(loop, &timers[i]);
+  }
+
+  ev_loop_destroy(loop);
+
+  if (a) {
+    a->used = 0;
+  }
+
+  return 0;
+}
+
+int main(void) {
+  const int iterations = bench_read_iterations();
+  const int runs = bench_read_runs();
+  const int target = iterations / 100 > 1 ? iterations / 100 : 1;
+  arena a;
+
+  a.base = (char*)malloc(ARENA_SIZE);
+  a.used = 0;
+
+  if (!a.base) {
+    return 1;
+  }
+
+  for (int use_arena = 0; use_arena < 2; ++use_arena) {
+    double total_seconds = 0.0;
+
+    for (int r = 0; r < runs; ++r) {
+      struct timespec start;
+      struct timespec end;
+
+      if (bench_clock_now(&start) != 0) {
+        perror("clock_gettime(START)");
+        return 2;
+      }
+
+      for (int i = 0; i < target; ++i) {
+        int rc = run_loop_lifecycle(use_arena ? &a : 0);
+
+        if (rc != 0) {
+          return rc;
+        }
+      }
+
+      if (bench_clock_now(&end) != 0) {
+        perror("clock_gettime(END)");
+        return 3;
+      }
+
+      total_seconds += bench_elapsed_seconds(&start, &end);
+    }
+
+    bench_print_result(use_arena ? "loop-lifecycle-arena" : "loop-lifecycle-malloc", target, total_seconds / runs,
+                       ev_version_major(), ev_version_minor(), runs);
+  }
+
+  free(a.base);
+  return 0;
+}
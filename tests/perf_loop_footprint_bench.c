@@ -0,0 +1,109 @@
+#include <ev.h>
+#include "perf_bench_common.h"
+
+/* thousands of mostly idle loops per process: creation time, and the heap */
+/* bytes each one holds after a first iteration, before any watchers */
+#define LOOPS 1000
+
+typedef struct {
+  long bytes;
+  long first; /* the loop structure itself */
+} counter;
+
+static struct ev_loop* loops[LOOPS];
+
+/* keeps the size in front of every block, so live bytes can be tracked */
+static void* counting_alloc(void* ptr, long size, void* ctx) {
+  counter* c = (counter*)ctx;
+  long* block = ptr ? (long*)ptr - 2 : 0;
+
+  if (block) {
+    c->bytes -= block[0];
+  }
+
+  if (!size) {
+    free(block);
+    return 0;
+  }
+
+  block = (long*)realloc(block, size + 2 * sizeof(long));
+
+  if (!block) {
+    return 0;
+  }
+
+  block[0] = size;
+  c->bytes += size;
+
+  if (!c->first) {
+    c->first = size;
+  }
+
+  return block + 2;
+}
+
+static int run_footprint_bench(counter* c, int target, double* seconds_out) {
+  struct timespec start;
+  struct timespec end;
+
+  if (bench_clock_now(&start) != 0) {
+    perror("clock_gettime(START)");
+    return 1;
+  }
+
+  for (int n = 0; n < target; n += LOOPS) {
+    for (int i = 0; i < LOOPS; ++i) {
+      loops[i] = ev_loop_new_with_allocator(EVFLAG_AUTO, counting_alloc, c);
+
+      if (!loops[i]) {
+        fprintf(stderr, "failed to create ev loop\n");
+        return 2;
+      }
+
+      ev_run(loops[i], EVRUN_NOWAIT);
+    }
+
+    for (int i = 0; i < LOOPS; ++i) {
+      ev_loop_destroy(loops[i]);
+    }
+  }
+
+  if (bench_clock_now(&end) != 0) {
+    perror("clock_gettime(END)");
+    return 3;
+  }
+
+  *seconds_out = bench_elapsed_seconds(&start, &end);
+
+  return 0;
+}
+
+int main(void) {
+  const int iterations = bench_read_iterations();
+  const int runs = bench_read_runs();
+  const int target = iterations / 10 > LOOPS ? iterations / 10 / LOOPS * LOOPS : LOOPS;
+  double total_seconds = 0.0;
+  counter c = {0, 0};
+
+  for (int r = 0; r < runs; ++r) {
+    double seconds = 0.0;
+    int rc = run_footprint_bench(&c, target, &seconds);
+
+    if (rc != 0) {
+      return rc;
+    }
+
+    total_seconds += seconds;
+  }
+
+  bench_print_result("loop-create-destroy", target, total_seconds / runs, ev_version_major(), ev_version_minor(),
+                     runs);
+
+  /* what an idle loop holds */
+  loops[0] = ev_loop_new_with_allocator(EVFLAG_AUTO, counting_alloc, &c);
+  ev_run(loops[0], EVRUN_NOWAIT);
+  printf("scenario=idle-loop-footprint struct_bytes=%ld heap_bytes=%ld\n", c.first, c.bytes);
+  ev_loop_destroy(loops[0]);
+
+  return 0;
+}
@@ -0,0 +1,252 @@
+#include <ev.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include "perf_bench_common.h"
+
+/* loopback echo: N server loops and N client loops, four connections per loop */
+#define MSG_SIZE 64
+#define CONNS_PER_LOOP 4
+#define MAX_LOOPS 32
+#define MAX_CONNS (MAX_LOOPS * CONNS_PER_LOOP)
+#define MAX_FD 4096
+
+typedef struct {
+  ev_io io;
+  int fd;
+  int got;
+  char buf[MSG_SIZE];
+} conn;
+
+static conn conns[MAX_FD]; /* indexed by fd */
+static int conn_count;
+static int target_round_trips;
+static int round_trips;
+static int stopping;
+static struct ev_loop* main_loop;
+static ev_async done_watcher;
+
+static void set_nonblock(int fd) {
+  int one = 1;
+
+  fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+  setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+}
+
+static void server_cb(EV_P_ ev_io* w, int revents) {
+  conn* c = (conn*)w;
+  char buf[4096];
+  ssize_t n;
+
+  (void)revents;
+
+  n = read(c->fd, buf, sizeof(buf));
+
+  if (n <= 0) {
+    if (n < 0 && errno == EAGAIN)
+      return;
+
+    ev_io_stop(EV_A_ w);
+    return;
+  }
+
+  if (write(c->fd, buf, (size_t)n) != n)
+    ev_io_stop(EV_A_ w);
+}
+
+static void client_cb(EV_P_ ev_io* w, int revents) {
+  conn* c = (conn*)w;
+  ssize_t n;
+
+  (void)revents;
+
+  n = read(c->fd, c->buf + c->got, MSG_SIZE - c->got);
+
+  if (n <= 0) {
+    if (n < 0 && errno == EAGAIN)
+      return;
+
+    ev_io_stop(EV_A_ w);
+    return;
+  }
+
+  c->got += (int)n;
+
+  if (c->got < MSG_SIZE)
+    return;
+
+  c->got = 0;
+
+  if (__atomic_add_fetch(&round_trips, 1, __ATOMIC_RELAXED) == target_round_trips)
+    ev_async_send(main_loop, &done_watcher);
+
+  if (__atomic_load_n(&stopping, __ATOMIC_RELAXED) || write(c->fd, c->buf, MSG_SIZE) != MSG_SIZE)
+    ev_io_stop(EV_A_ w);
+}
+
+/* invoked in the loop that was handed the fd */
+static void server_conn_cb(EV_P_ int fd, void* arg) {
+  conn* c = conns + fd;
+
+  (void)arg;
+
+  c->fd = fd;
+  ev_io_init(&c->io, server_cb, fd, EV_READ);
+  ev_io_start(EV_A_ & c->io);
+}
+
+static void client_conn_cb(EV_P_ int fd, void* arg) {
+  conn* c = conns + fd;
+
+  (void)arg;
+
+  c->fd = fd;
+  c->got = 0;
+  memset(c->buf, 'x', MSG_SIZE);
+  ev_io_init(&c->io, client_cb, fd, EV_READ);
+  ev_io_start(EV_A_ & c->io);
+
+  if (write(fd, c->buf, MSG_SIZE) != MSG_SIZE)
+    ev_io_stop(EV_A_ & c->io);
+}
+
+static void done_cb(EV_P_ ev_async* w, int revents) {
+  (void)w;
+  (void)revents;
+
+  ev_break(EV_A_ EVBREAK_ALL);
+}
+
+static int run_echo_bench(int nloops, double* seconds_out) {
+  struct ev_loop_group* servers = ev_loop_group_new(nloops, EVFLAG_AUTO, EVGROUP_ROUNDROBIN, server_conn_cb, 0);
+  struct ev_loop_group* clients = ev_loop_group_new(nloops, EVFLAG_AUTO, EVGROUP_ROUNDROBIN, client_conn_cb, 0);
+  struct sockaddr_in addr;
+  socklen_t len = sizeof(addr);
+  struct timespec start;
+  struct timespec end;
+  int fds[2 * MAX_CONNS];
+  int nfds = 0;
+  int lfd;
+  int i;
+
+  if (!servers || !clients) {
+    fprintf(stderr, "failed to create loop groups\n");
+    return 1;
+  }
+
+  lfd = socket(AF_INET, SOCK_STREAM, 0);
+  memset(&addr, 0, sizeof(addr));
+  addr.sin_family = AF_INET;
+  addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+  if (lfd < 0 || bind(lfd, (struct sockaddr*)&addr, sizeof(addr)) || listen(lfd, MAX_CONNS) ||
+      getsockname(lfd, (struct sockaddr*)&addr, &len)) {
+    perror("listen");
+    return 2;
+  }
+
+  conn_count = nloops * CONNS_PER_LOOP;
+  round_trips = 0;
+  stopping = 0;
+
+  /* the main thread plays acceptor and hands both ends to the groups */
+  for (i = 0; i < conn_count; ++i) {
+    int cfd = socket(AF_INET, SOCK_STREAM, 0);
+    int sfd;
+
+    if (cfd < 0 || connect(cfd, (struct sockaddr*)&addr, sizeof(addr)) || (sfd = accept(lfd, 0, 0)) < 0) {
+      perror("connect");
+      return 3;
+    }
+
+    if (cfd >= MAX_FD || sfd >= MAX_FD) {
+      fprintf(stderr, "fd out of range\n");
+      return 3;
+    }
+
+    set_nonblock(cfd);
+    set_nonblock(sfd);
+    fds[nfds++] = cfd;
+    fds[nfds++] = sfd;
+
+    if (ev_loop_group_dispatch(servers, sfd) < 0 || ev_loop_group_dispatch(clients, cfd) < 0) {
+      fprintf(stderr, "dispatch failed\n");
+      return 4;
+    }
+  }
+
+  ev_async_init(&done_watcher, done_cb);
+  ev_async_start(main_loop, &done_watcher);
+
+  if (bench_clock_now(&start) != 0) {
+    perror("clock_gettime(START)");
+    return 5;
+  }
+
+  ev_loop_group_start(servers);
+  ev_loop_group_start(clients);
+  ev_run(main_loop, 0);
+
+  if (bench_clock_now(&end) != 0) {
+    perror("clock_gettime(END)");
+    return 6;
+  }
+
+  __atomic_store_n(&stopping, 1, __ATOMIC_RELAXED);
+  ev_async_stop(main_loop, &done_watcher);
+
+  ev_loop_group_destroy(clients);
+  ev_loop_group_destroy(servers);
+
+  for (i = 0; i < nfds; ++i)
+    close(fds[i]);
+
+  close(lfd);
+
+  *seconds_out = bench_elapsed_seconds(&start, &end);
+
+  return 0;
+}
+
+int main(void) {
+  const int iterations = bench_read_iterations();
+  const int runs = bench_read_runs();
+  const char* max_env = getenv("LIBEV_BENCH_MAX_LOOPS");
+  const int max_loops = max_env && atoi(max_env) > 0 ? atoi(max_env) : MAX_LOOPS;
+
+  main_loop = ev_loop_new(EVFLAG_AUTO);
+
+  if (!main_loop) {
+    fprintf(stderr, "failed to create ev loop\n");
+    return 1;
+  }
+
+  /* echo round trips are far more expensive than the other benchmark iterations */
+  target_round_trips = iterations / 10 > 0 ? iterations / 10 : 1;
+
+  for (int nloops = 1; nloops <= max_loops && nloops <= MAX_LOOPS; nloops *= 2) {
+    double total_seconds = 0.0;
+    char scenario[64];
+
+    for (int i = 0; i < runs; ++i) {
+      double seconds = 0.0;
+      int rc = run_echo_bench(nloops, &seconds);
+
+      if (rc != 0) {
+        return rc;
+      }
+
+      total_seconds += seconds;
+    }
+
+    snprintf(scenario, sizeof(scenario), "loop-group-echo-%d", nloops);
+    bench_print_result(scenario, target_round_trips, total_seconds / runs, ev_version_major(), ev_version_minor(), runs);
+  }
+
+  ev_loop_destroy(main_loop);
+  return 0;
+}
@@ -0,0 +1,83 @@
+#include <ev.h>
+#include "perf_bench_common.h"
+
+/* a fresh loop taking its first burst of timers and pending events: growing */
+/* the arrays step by step against ev_loop_reserve sizing them up front */
+#define BURST 16384
+
+static ev_timer timers[BURST];
+
+static void timer_cb(EV_P_ ev_timer* w, int revents) {
+  (void)loop;
+  (void)w;
+  (void)revents;
+}
+
+static int run_burst(int reserve) {
+  struct ev_loop* loop = ev_loop_new(EVFLAG_AUTO);
+
+  if (!loop) {
+    fprintf(stderr, "failed to create ev loop\n");
+    return 1;
+  }
+
+  if (reserve) {
+    ev_loop_reserve(loop, 0, BURST, BURST);
+  }
+
+  for (int i = 0; i < BURST; ++i) {
+    ev_timer_init(&timers[i], timer_cb, 3600. + i, 0.);
+    ev_timer_start(loop, &timers[i]);
+    ev_feed_event(loop, &timers[i], EV_TIMER);
+  }
+
+  ev_run(loop, EVRUN_NOWAIT);
+
+  for (int i = 0; i < BURST; ++i) {
+    ev_timer_stop(loop, &timers[i]);
+  }
+
+  ev_loop_destroy(loop);
+
+  return 0;
+}
+
+int main(void) {
+  const int iterations = bench_read_iterations();
+  const int runs = bench_read_runs();
+  const int target = iterations / 1000 > 1 ? iterations / 1000 : 1;
+
+  for (int reserve = 0; reserve < 2; ++reserve) {
+    double total_seconds = 0.0;
+
+    for (int r = 0; r < runs; ++r) {
+      struct timespec start;
+      struct timespec end;
+
+      if (bench_clock_now(&start) != 0) {
+        perror("clock_gettime(START)");
+        return 2;
+      }
+
+      for (int i = 0; i < target; ++i) {
+        int rc = run_burst(reserve);
+
+        if (rc != 0) {
+          return rc;
+        }
+      }
+
+      if (bench_clock_now(&end) != 0) {
+        perror("clock_gettime(END)");
+        return 3;
+      }
+
+      total_seconds += bench_elapsed_seconds(&start, &end);
+    }
+
+    bench_print_result(reserve ? "loop-burst-reserved" : "loop-burst-growing", target, total_seconds / runs,
+                       ev_version_major(), ev_version_minor(), runs);
+  }
+
+  return 0;
+}
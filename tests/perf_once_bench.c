@@ -0,0 +1,95 @@
+#include <ev.h>
+#include "perf_bench_common.h"
+
+/* one-shot waits as an rpc client issues them: each completion starts the */
+/* next one, with pooled ev_once blocks and with caller-provided storage */
+#define INFLIGHT 64
+
+static struct ev_loop* loop;
+static ev_once_storage storage[INFLIGHT];
+static int remaining;
+
+static void pooled_cb(int revents, void* arg) {
+  (void)revents;
+
+  if (--remaining >= INFLIGHT)
+    ev_once(loop, -1, 0, 0., pooled_cb, arg);
+}
+
+static void storage_cb(int revents, void* arg) {
+  (void)revents;
+
+  if (--remaining >= INFLIGHT)
+    ev_once_start(loop, (ev_once_storage*)arg, -1, 0, 0., storage_cb, arg);
+}
+
+static int run_once_bench(int use_storage, int target, double* seconds_out) {
+  struct timespec start;
+  struct timespec end;
+
+  remaining = target;
+
+  if (bench_clock_now(&start) != 0) {
+    perror("clock_gettime(START)");
+    return 1;
+  }
+
+  for (int i = 0; i < INFLIGHT; ++i) {
+    if (use_storage) {
+      ev_once_start(loop, &storage[i], -1, 0, 0., storage_cb, &storage[i]);
+    } else {
+      ev_once(loop, -1, 0, 0., pooled_cb, 0);
+    }
+  }
+
+  ev_run(loop, 0);
+
+  if (bench_clock_now(&end) != 0) {
+    perror("clock_gettime(END)");
+    return 2;
+  }
+
+  if (remaining != 0) {
+    fprintf(stderr, "lost one-shot callbacks\n");
+    return 3;
+  }
+
+  *seconds_out = bench_elapsed_seconds(&start, &end);
+
+  return 0;
+}
+
+int main(void) {
+  const int iterations = bench_read_iterations();
+  const int runs = bench_read_runs();
+  const int target = iterations > INFLIGHT ? iterations : INFLIGHT;
+
+  loop = ev_loop_new(EVFLAG_AUTO);
+
+  if (!loop) {
+    fprintf(stderr, "failed to create ev loop\n");
+    return 1;
+  }
+
+  for (int use_storage = 0; use_storage < 2; ++use_storage) {
+    double total_seconds = 0.0;
+
+    for (int r = 0; r < runs; ++r) {
+      double seconds = 0.0;
+      int rc = run_once_bench(use_storage, target, &seconds);
+
+      if (rc != 0) {
+        return rc;
+      }
+
+      total_seconds += seconds;
+    }
+
+    bench_print_result(use_storage ? "once-caller-storage" : "once-pooled", target, total_seconds / runs,
+                       ev_version_major(), ev_version_minor(), runs);
+  }
+
+  ev_loop_destroy(loop);
+
+  return 0;
+}
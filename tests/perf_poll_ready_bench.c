@@ -0,0 +1,123 @@
+#include <ev.h>
+#include <fcntl.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include "perf_bench_common.h"
+
+/* many sockets become readable at once: handle them through callbacks */
+/* from ev_run, or pull them in batches with ev_poll_ready */
+#define SOCKS 64
+#define BATCH 16
+
+static int fds[SOCKS][2];
+static ev_io ios[SOCKS];
+static long handled;
+
+static inline void consume(int fd) {
+  char c;
+
+  if (read(fd, &c, 1) == 1) {
+    ++handled;
+  }
+}
+
+static void read_cb(EV_P_ ev_io* w, int revents) {
+  (void)loop;
+  (void)revents;
+
+  consume(ev_io_fd(w));
+}
+
+static int run_ready_bench(int pull, int rounds, double* seconds_out) {
+  struct ev_loop* loop = ev_loop_new(EVFLAG_AUTO);
+  ev_ready ready[BATCH];
+  struct timespec start;
+  struct timespec end;
+
+  if (!loop) {
+    fprintf(stderr, "failed to create ev loop\n");
+    return 1;
+  }
+
+  for (int i = 0; i < SOCKS; ++i) {
+    if (socketpair(AF_UNIX, SOCK_STREAM, 0, fds[i])) {
+      perror("socketpair");
+      return 2;
+    }
+
+    fcntl(fds[i][0], F_SETFL, O_NONBLOCK);
+    ev_io_init(&ios[i], pull ? 0 : read_cb, fds[i][0], EV_READ);
+    ev_io_start(loop, &ios[i]);
+  }
+
+  handled = 0;
+
+  if (bench_clock_now(&start) != 0) {
+    perror("clock_gettime(START)");
+    return 3;
+  }
+
+  for (int r = 0; r < rounds; ++r) {
+    for (int i = 0; i < SOCKS; ++i) {
+      if (write(fds[i][1], "x", 1) != 1) {
+        perror("write");
+        return 4;
+      }
+    }
+
+    while (handled < (long)(r + 1) * SOCKS) {
+      if (pull) {
+        int n = ev_poll_ready(loop, ready, BATCH, 1.);
+
+        for (int i = 0; i < n; ++i) {
+          consume(((ev_io*)ready[i].w)->fd);
+        }
+      } else {
+        ev_run(loop, EVRUN_ONCE);
+      }
+    }
+  }
+
+  if (bench_clock_now(&end) != 0) {
+    perror("clock_gettime(END)");
+    return 5;
+  }
+
+  for (int i = 0; i < SOCKS; ++i) {
+    ev_io_stop(loop, &ios[i]);
+    close(fds[i][0]);
+    close(fds[i][1]);
+  }
+
+  ev_loop_destroy(loop);
+
+  *seconds_out = bench_elapsed_seconds(&start, &end);
+
+  return 0;
+}
+
+int main(void) {
+  const int iterations = bench_read_iterations();
+  const int runs = bench_read_runs();
+  const int rounds = iterations / SOCKS > 1 ? iterations / SOCKS : 1;
+
+  for (int pull = 0; pull < 2; ++pull) {
+    double total_seconds = 0.0;
+
+    for (int i = 0; i < runs; ++i) {
+      double seconds = 0.0;
+      int rc = run_ready_bench(pull, rounds, &seconds);
+
+      if (rc != 0) {
+        return rc;
+      }
+
+      total_seconds += seconds;
+    }
+
+    bench_print_result(pull ? "ready-pull" : "ready-callbacks", rounds * SOCKS, total_seconds / runs,
+                       ev_version_major(), ev_version_minor(), runs);
+  }
+
+  return 0;
+}
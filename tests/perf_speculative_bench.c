@@ -0,0 +1,130 @@
+#include <ev.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include "perf_bench_common.h"
+
+/* bulk pipe transfer: the writer refills the pipe whenever it drains, the */
+/* reader consumes one CHUNK per callback. plain watchers need a kernel poll */
+/* per chunk, EV_SPECULATIVE ones keep reading until EAGAIN */
+#define CHUNK 4096
+
+static int fds[2];
+static ev_io reader;
+static ev_io writer;
+static long long target_bytes;
+static long long read_bytes;
+static long long written_bytes;
+static char buf[CHUNK * 16];
+
+static void reader_cb(EV_P_ ev_io* w, int revents) {
+  ssize_t n;
+
+  (void)revents;
+
+  n = read(fds[0], buf, CHUNK);
+
+  if (n > 0) {
+    read_bytes += n;
+
+    if (read_bytes >= target_bytes) {
+      ev_io_stop(EV_A_ w);
+      ev_io_stop(EV_A_ & writer);
+    }
+  } else if (n < 0 && errno == EAGAIN) {
+    ev_io_eagain(EV_A_ w);
+  }
+}
+
+static void writer_cb(EV_P_ ev_io* w, int revents) {
+  ssize_t n;
+
+  (void)loop;
+  (void)w;
+  (void)revents;
+
+  n = write(fds[1], buf, sizeof(buf));
+
+  if (n > 0) {
+    written_bytes += n;
+  }
+}
+
+static int run_pipe_bench(int speculative, double* seconds_out, unsigned int* iterations_out) {
+  struct ev_loop* loop = ev_loop_new(EVFLAG_AUTO);
+  struct timespec start;
+  struct timespec end;
+
+  if (!loop) {
+    fprintf(stderr, "failed to create ev loop\n");
+    return 1;
+  }
+
+  if (pipe(fds)) {
+    perror("pipe");
+    return 2;
+  }
+
+  fcntl(fds[0], F_SETFL, O_NONBLOCK);
+  fcntl(fds[1], F_SETFL, O_NONBLOCK);
+
+  read_bytes = 0;
+  written_bytes = 0;
+
+  ev_io_init(&reader, reader_cb, fds[0], EV_READ | (speculative ? EV_SPECULATIVE : 0));
+  ev_io_start(loop, &reader);
+  ev_io_init(&writer, writer_cb, fds[1], EV_WRITE);
+  ev_io_start(loop, &writer);
+
+  if (bench_clock_now(&start) != 0) {
+    perror("clock_gettime(START)");
+    return 3;
+  }
+
+  ev_run(loop, 0);
+
+  if (bench_clock_now(&end) != 0) {
+    perror("clock_gettime(END)");
+    return 4;
+  }
+
+  *iterations_out = ev_iteration(loop);
+
+  ev_loop_destroy(loop);
+  close(fds[0]);
+  close(fds[1]);
+
+  *seconds_out = bench_elapsed_seconds(&start, &end);
+
+  return 0;
+}
+
+int main(void) {
+  const int iterations = bench_read_iterations();
+  const int runs = bench_read_runs();
+
+  target_bytes = (long long)iterations * 256;
+
+  for (int speculative = 0; speculative < 2; ++speculative) {
+    double total_seconds = 0.0;
+    unsigned int loop_iterations = 0;
+
+    for (int i = 0; i < runs; ++i) {
+      double seconds = 0.0;
+      int rc = run_pipe_bench(speculative, &seconds, &loop_iterations);
+
+      if (rc != 0) {
+        return rc;
+      }
+
+      total_seconds += seconds;
+    }
+
+    bench_print_result(speculative ? "pipe-speculative" : "pipe-plain", (int)(target_bytes / CHUNK),
+                       total_seconds / runs, ev_version_major(), ev_version_minor(), runs);
+    printf("scenario=%s mib_per_second=%.1f loop_iterations=%u\n", speculative ? "pipe-speculative" : "pipe-plain",
+           target_bytes / (total_seconds / runs) / (1024. * 1024.), loop_iterations);
+  }
+
+  return 0;
+}
@@ -0,0 +1,131 @@
+#include <ev.h>
+#include "perf_bench_common.h"
+
+/* submission-to-completion latency of ev_work with one job in flight, */
+/* and throughput with batches of jobs completing through one wakeup */
+#define BATCH 256
+
+static ev_work batch[BATCH];
+static ev_work single;
+static int target_jobs;
+static int done_jobs;
+static double* latencies;
+static struct timespec submitted_at;
+
+static void noop_work(ev_work* w) {
+  (void)w;
+}
+
+static void single_cb(EV_P_ ev_work* w, int revents) {
+  struct timespec now;
+
+  (void)revents;
+
+  bench_clock_now(&now);
+  latencies[done_jobs] = bench_elapsed_seconds(&submitted_at, &now);
+
+  if (++done_jobs < target_jobs) {
+    submitted_at = now;
+    ev_work_start(EV_A_ w);
+  }
+}
+
+static void batch_cb(EV_P_ ev_work* w, int revents) {
+  (void)revents;
+
+  if (++done_jobs + BATCH <= target_jobs) {
+    ev_work_start(EV_A_ w);
+  }
+}
+
+static int cmp_double(const void* a, const void* b) {
+  double x = *(const double*)a;
+  double y = *(const double*)b;
+
+  return x < y ? -1 : x > y;
+}
+
+static int run_work_bench(int batched, double* seconds_out) {
+  struct ev_loop* loop = ev_loop_new(EVFLAG_AUTO);
+  struct timespec start;
+  struct timespec end;
+
+  if (!loop) {
+    fprintf(stderr, "failed to create ev loop\n");
+    return 1;
+  }
+
+  done_jobs = 0;
+
+  if (bench_clock_now(&start) != 0) {
+    perror("clock_gettime(START)");
+    ev_loop_destroy(loop);
+    return 2;
+  }
+
+  if (batched) {
+    for (int i = 0; i < BATCH && i < target_jobs; ++i) {
+      ev_work_init(&batch[i], batch_cb, noop_work);
+      ev_work_start(loop, &batch[i]);
+    }
+  } else {
+    submitted_at = start;
+    ev_work_init(&single, single_cb, noop_work);
+    ev_work_start(loop, &single);
+  }
+
+  ev_run(loop, 0);
+
+  if (bench_clock_now(&end) != 0) {
+    perror("clock_gettime(END)");
+    ev_loop_destroy(loop);
+    return 3;
+  }
+
+  ev_loop_destroy(loop);
+
+  *seconds_out = bench_elapsed_seconds(&start, &end);
+
+  return 0;
+}
+
+int main(void) {
+  const int iterations = bench_read_iterations();
+  const int runs = bench_read_runs();
+
+  /* every job involves two thread handoffs */
+  target_jobs = iterations / 10 > BATCH ? iterations / 10 : BATCH;
+  latencies = (double*)malloc(sizeof(double) * target_jobs);
+
+  if (!latencies) {
+    return 1;
+  }
+
+  for (int batched = 0; batched < 2; ++batched) {
+    double total_seconds = 0.0;
+
+    for (int i = 0; i < runs; ++i) {
+      double seconds = 0.0;
+      int rc = run_work_bench(batched, &seconds);
+
+      if (rc != 0) {
+        return rc;
+      }
+
+      total_seconds += seconds;
+    }
+
+    bench_print_result(batched ? "work-batched" : "work-single", target_jobs, total_seconds / runs, ev_version_major(),
+                       ev_version_minor(), runs);
+
+    if (!batched) {
+      /* percentiles of the last run */
+      qsort(latencies, target_jobs, sizeof(double), cmp_double);
+      printf("scenario=work-latency p50_us=%.2f p99_us=%.2f max_us=%.2f\n", latencies[target_jobs / 2] * 1e6,
+             latencies[(int)(target_jobs * 0.99)] * 1e6, latencies[target_jobs - 1] * 1e6);
+    }
+  }
+
+  free(latencies);
+  return 0;
+}
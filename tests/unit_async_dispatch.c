@@ -0,0 +1,101 @@
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "ev.h"
+
+/* more watchers than the default sent map has bits, so indices alias */
+#define ASYNC_COUNT 10000
+
+static ev_async asyncs[ASYNC_COUNT];
+static int hits[ASYNC_COUNT];
+static int total_hits;
+
+static void die(const char* msg) {
+  fprintf(stderr, "%s\n", msg);
+  exit(EXIT_FAILURE);
+}
+
+static void async_cb(EV_P_ ev_async* w, int revents) {
+  (void)loop;
+
+  if (!(revents & EV_ASYNC))
+    die("async callback without EV_ASYNC");
+
+  ++hits[w - asyncs];
+  ++total_hits;
+}
+
+static void reset_hits(void) {
+  int i;
+
+  for (i = 0; i < ASYNC_COUNT; ++i)
+    hits[i] = 0;
+
+  total_hits = 0;
+}
+
+static void test_only_signalled_fire(struct ev_loop* loop) {
+  static const int picks[] = {0, 1, 63, 64, 4095, 4096, 8191, ASYNC_COUNT - 1};
+  int i;
+
+  reset_hits();
+
+  for (i = 0; i < (int)(sizeof(picks) / sizeof(picks[0])); ++i)
+    ev_async_send(loop, &asyncs[picks[i]]);
+
+  /* coalescing: a second send before the loop runs is merged */
+  ev_async_send(loop, &asyncs[picks[0]]);
+
+  ev_run(loop, EVRUN_NOWAIT);
+
+  if (total_hits != (int)(sizeof(picks) / sizeof(picks[0])))
+    die("unexpected number of async callbacks");
+
+  for (i = 0; i < (int)(sizeof(picks) / sizeof(picks[0])); ++i)
+    if (hits[picks[i]] != 1)
+      die("signalled async watcher did not fire exactly once");
+
+  for (i = 0; i < ASYNC_COUNT; ++i)
+    if (ev_async_pending(&asyncs[i]))
+      die("async watcher still marked as sent after dispatch");
+}
+
+static void test_stop_moves_sent_watcher(struct ev_loop* loop) {
+  reset_hits();
+
+  /* the last watcher gets moved into the stopped watcher's slot, */
+  /* after it was marked under its old index */
+  ev_async_send(loop, &asyncs[ASYNC_COUNT - 1]);
+  ev_async_stop(loop, &asyncs[5]);
+
+  ev_run(loop, EVRUN_NOWAIT);
+
+  if (total_hits != 1 || hits[ASYNC_COUNT - 1] != 1)
+    die("moved async watcher lost its pending send");
+
+  if (hits[5])
+    die("stopped async watcher was invoked");
+}
+
+int main(void) {
+  struct ev_loop* loop = ev_loop_new(EVFLAG_AUTO);
+  int i;
+
+  if (!loop)
+    die("ev_loop_new failed");
+
+  for (i = 0; i < ASYNC_COUNT; ++i) {
+    ev_async_init(&asyncs[i], async_cb);
+    ev_async_start(loop, &asyncs[i]);
+  }
+
+  test_only_signalled_fire(loop);
+  test_stop_moves_sent_watcher(loop);
+
+  for (i = 0; i < ASYNC_COUNT; ++i)
+    ev_async_stop(loop, &asyncs[i]);
+
+  ev_loop_destroy(loop);
+
+  return EXIT_SUCCESS;
+}
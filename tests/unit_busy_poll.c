@@ -0,0 +1,85 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "ev.h"
+
+static int io_fired;
+static int timer_fired;
+
+static void die(const char* msg) {
+  fprintf(stderr, "%s\n", msg);
+  exit(EXIT_FAILURE);
+}
+
+static void io_cb(EV_P_ ev_io* w, int revents) {
+  char c;
+
+  if (!(revents & EV_READ) || read(ev_io_fd(w), &c, 1) != 1)
+    die("busy-polled io watcher fired without data");
+
+  ++io_fired;
+  ev_io_stop(EV_A_ w);
+}
+
+static void timer_cb(EV_P_ ev_timer* w, int revents) {
+  (void)w;
+  (void)revents;
+
+  ++timer_fired;
+  ev_break(EV_A_ EVBREAK_ALL);
+}
+
+int main(void) {
+  struct ev_loop* loop = ev_loop_new(EVFLAG_AUTO);
+  ev_io io;
+  ev_io idle_io;
+  ev_timer timer;
+  ev_tstamp start;
+  int fds[2];
+
+  if (!loop)
+    die("ev_loop_new failed");
+
+  if (socketpair(AF_UNIX, SOCK_STREAM, 0, fds))
+    die("socketpair failed");
+
+  /* a budget far longer than the timeout must not delay the timer */
+  ev_set_busy_poll(loop, 10.);
+
+  ev_io_init(&io, io_cb, fds[0], EV_READ);
+  ev_io_start(loop, &io);
+
+  if (write(fds[1], "x", 1) != 1)
+    die("write failed");
+
+  ev_run(loop, EVRUN_ONCE);
+
+  if (io_fired != 1)
+    die("io event found while spinning was not delivered");
+
+  /* nothing readable, so the loop spins until the timer is due */
+  ev_io_init(&idle_io, io_cb, fds[1], EV_READ);
+  ev_io_start(loop, &idle_io);
+  ev_timer_init(&timer, timer_cb, 0.05, 0.);
+  ev_timer_start(loop, &timer);
+
+  start = ev_time();
+  ev_run(loop, 0);
+
+  if (!timer_fired)
+    die("timer did not fire in busy-poll mode");
+
+  if (ev_time() - start > 1.)
+    die("busy-poll budget delayed the timer");
+
+  ev_set_busy_poll(loop, 0.);
+  ev_io_stop(loop, &idle_io);
+  ev_loop_destroy(loop);
+
+  close(fds[0]);
+  close(fds[1]);
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,147 @@
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+/* embeds the library with the compact watcher layout: pending and priority */
+/* share one word and there is no data member, the core must not notice */
+#define EV_COMPACT 2
+#include "ev.c"
+
+#define FEEDS 5000
+
+/* the default layout, for comparison */
+struct stock_io {
+  int active;
+  int pending;
+  int priority;
+  void* data;
+  void (*cb)(void);
+  void* next;
+  int fd;
+  int events;
+};
+
+typedef struct {
+  ev_io io;
+  int fired;
+} conn;
+
+static ev_idle feeds[FEEDS];
+static int fed;
+static int order[2];
+static int norder;
+static int timer_fired;
+
+static void die(const char* msg) {
+  fprintf(stderr, "%s\n", msg);
+  exit(EXIT_FAILURE);
+}
+
+static void conn_cb(EV_P_ ev_io* w, int revents) {
+  conn* c = (conn*)(((char*)w) - offsetof(conn, io));
+  char buf[8];
+
+  (void)revents;
+
+  if (read(c->io.fd, buf, sizeof(buf)) <= 0)
+    die("read failed");
+
+  ++c->fired;
+  ev_io_stop(EV_A_ w);
+}
+
+static void feed_cb(EV_P_ ev_idle* w, int revents) {
+  (void)loop;
+  (void)revents;
+
+  if (norder < 2)
+    order[norder++] = ev_priority(w);
+
+  ++fed;
+}
+
+static void timer_cb(EV_P_ ev_timer* w, int revents) {
+  (void)revents;
+
+  if (++timer_fired == 3)
+    ev_timer_stop(EV_A_ w);
+}
+
+static void test_layout(void) {
+  ev_idle w;
+
+  if (sizeof(ev_io) + sizeof(void*) >= sizeof(struct stock_io))
+    die("compact ev_io is not smaller than the default layout");
+
+  ev_idle_init(&w, feed_cb);
+
+  for (int pri = EV_MINPRI - 1; pri <= EV_MAXPRI + 1; ++pri) {
+    ev_set_priority(&w, pri);
+
+    if (ev_priority(&w) != (pri < EV_MINPRI ? EV_MINPRI : pri > EV_MAXPRI ? EV_MAXPRI : pri))
+      die("priority does not survive the packed layout");
+  }
+}
+
+static void test_pending(void) {
+  struct ev_loop* loop = ev_loop_new(EVFLAG_AUTO);
+
+  if (!loop)
+    die("ev_loop_new failed");
+
+  /* many pending watchers, so the packed pending index gets large */
+  for (int i = 0; i < FEEDS; ++i) {
+    ev_idle_init(&feeds[i], feed_cb);
+    ev_set_priority(&feeds[i], i & 1 ? EV_MAXPRI : EV_MINPRI);
+    ev_feed_event(loop, &feeds[i], EV_IDLE);
+  }
+
+  if (ev_pending_count(loop) != FEEDS)
+    die("pending count mismatch");
+
+  if (!ev_is_pending(&feeds[FEEDS - 1]) || ev_clear_pending(loop, &feeds[FEEDS - 1]) != EV_IDLE)
+    die("pending index does not survive the packed layout");
+
+  ev_invoke_pending(loop);
+
+  if (fed != FEEDS - 1 || order[0] != EV_MAXPRI || order[1] != EV_MAXPRI)
+    die("pending watchers were not invoked in priority order");
+
+  ev_loop_destroy(loop);
+}
+
+static void test_io_timer(void) {
+  struct ev_loop* loop = ev_loop_new(EVFLAG_AUTO);
+  conn c = {0};
+  ev_timer t;
+  int fds[2];
+
+  if (!loop || pipe(fds))
+    die("setup failed");
+
+  ev_io_init(&c.io, conn_cb, fds[0], EV_READ);
+  ev_io_start(loop, &c.io);
+  ev_timer_init(&t, timer_cb, 0.001, 0.001);
+  ev_timer_start(loop, &t);
+
+  if (write(fds[1], "x", 1) != 1)
+    die("write failed");
+
+  ev_run(loop, 0);
+
+  if (c.fired != 1 || timer_fired != 3)
+    die("io or timer watcher misbehaved");
+
+  close(fds[0]);
+  close(fds[1]);
+  ev_loop_destroy(loop);
+}
+
+int main(void) {
+  test_layout();
+  test_pending();
+  test_io_timer();
+
+  return EXIT_SUCCESS;
+}
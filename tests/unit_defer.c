@@ -0,0 +1,185 @@
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "ev.h"
+
+static ev_idle first, second;
+static ev_defer defers[4];
+static ev_defer chain;
+static ev_prepare prepare;
+static ev_check check;
+static ev_timer far_timer; /* stopped by the last chained call */
+static char log_buf[32];
+static int log_len;
+static int chain_runs;
+static int chain_target;
+
+static void die(const char* msg) {
+  fprintf(stderr, "%s\n", msg);
+  exit(EXIT_FAILURE);
+}
+
+static void note(char c) {
+  if (log_len < (int)sizeof(log_buf) - 1)
+    log_buf[log_len++] = c;
+
+  log_buf[log_len] = 0;
+}
+
+static void expect_log(const char* want) {
+  const char* got = log_buf;
+
+  while (*want && *want == *got)
+    ++want, ++got;
+
+  if (*want || *got) {
+    fprintf(stderr, "got \"%s\"\n", log_buf);
+    die("deferred calls made in the wrong order");
+  }
+
+  log_len = 0;
+  log_buf[0] = 0;
+}
+
+static void defer_cb(EV_P_ ev_defer* d) {
+  int i = (int)(d - defers);
+
+  if (ev_defer_is_queued(d))
+    die("deferred call still queued while it runs");
+
+  note('0' + i);
+
+  /* deferred calls may defer more */
+  if (i == 0 && d->data)
+    ev_defer_call(EV_A_ & defers[3]);
+}
+
+static void first_cb(EV_P_ ev_idle* w, int revents) {
+  (void)w;
+  (void)revents;
+
+  note('f');
+  ev_defer_call(EV_A_ & defers[0]);
+  ev_defer_call(EV_A_ & defers[1]);
+  ev_defer_call(EV_A_ & defers[0]); /* already queued */
+}
+
+static void second_cb(EV_P_ ev_idle* w, int revents) {
+  (void)w;
+  (void)revents;
+
+  note('s');
+  ev_defer_call(EV_A_ & defers[2]);
+}
+
+static void chain_cb(EV_P_ ev_defer* d) {
+  if (++chain_runs < chain_target)
+    ev_defer_call(EV_A_ d);
+  else
+    ev_timer_stop(EV_A_ & far_timer);
+}
+
+static void prepare_cb(EV_P_ ev_prepare* w, int revents) {
+  (void)loop;
+  (void)w;
+  (void)revents;
+
+  note('p');
+}
+
+static void check_cb(EV_P_ ev_check* w, int revents) {
+  (void)w;
+  (void)revents;
+
+  note('c');
+  ev_defer_call(EV_A_ & defers[0]);
+}
+
+static void far_cb(EV_P_ ev_timer* w, int revents) {
+  (void)loop;
+  (void)w;
+  (void)revents;
+
+  die("timer fired while deferred calls were left");
+}
+
+int main(void) {
+  struct ev_loop* loop = ev_loop_new(EVFLAG_AUTO);
+  int i;
+
+  if (!loop)
+    die("ev_loop_new failed");
+
+  for (i = 0; i < 4; ++i) {
+    ev_defer_init(&defers[i], defer_cb);
+    defers[i].data = 0;
+  }
+
+  ev_idle_init(&first, first_cb);
+  ev_idle_init(&second, second_cb);
+
+  /* made after the whole pass, in fifo order */
+  ev_feed_event(loop, &second, EV_CUSTOM);
+  ev_feed_event(loop, &first, EV_CUSTOM);
+  ev_invoke_pending(loop);
+  expect_log("fs012");
+
+  /* calls queued by deferred calls go to the end */
+  defers[0].data = &defers[3];
+  ev_feed_event(loop, &second, EV_CUSTOM);
+  ev_feed_event(loop, &first, EV_CUSTOM);
+  ev_invoke_pending(loop);
+  expect_log("fs0123");
+  defers[0].data = 0;
+
+  /* cancelling, including the tail */
+  for (i = 0; i < 3; ++i)
+    ev_defer_call(loop, &defers[i]);
+
+  ev_defer_cancel(loop, &defers[1]);
+  ev_defer_cancel(loop, &defers[2]);
+  ev_defer_cancel(loop, &defers[2]);
+  ev_defer_call(loop, &defers[3]);
+
+  if (ev_defer_is_queued(&defers[1]) || !ev_defer_is_queued(&defers[3]))
+    die("ev_defer_is_queued is wrong");
+
+  ev_invoke_pending(loop);
+  expect_log("03");
+
+  /* the limit caps a self-requeueing call per drain */
+  ev_set_defer_limit(loop, 3);
+  ev_defer_init(&chain, chain_cb);
+  chain_runs = 0;
+  chain_target = 10;
+  ev_defer_call(loop, &chain);
+  ev_invoke_pending(loop);
+
+  if (chain_runs != 3)
+    die("defer limit not honoured");
+
+  /* but the rest runs without the loop blocking */
+  ev_timer_init(&far_timer, far_cb, 5., 0.);
+  ev_timer_start(loop, &far_timer);
+  ev_run(loop, 0);
+
+  if (chain_runs != chain_target)
+    die("deferred calls lost");
+
+  ev_set_defer_limit(loop, 0);
+
+  /* calls deferred by check watchers are made before the next iteration */
+  ev_prepare_init(&prepare, prepare_cb);
+  ev_prepare_start(loop, &prepare);
+  ev_check_init(&check, check_cb);
+  ev_check_start(loop, &check);
+  ev_run(loop, EVRUN_NOWAIT);
+  ev_run(loop, EVRUN_NOWAIT);
+  expect_log("pc0pc0");
+
+  ev_prepare_stop(loop, &prepare);
+  ev_check_stop(loop, &check);
+  ev_loop_destroy(loop);
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,161 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "ev.h"
+
+/* prepare, check and idle watchers are queued and invoked in bulk when */
+/* possible, this must not be observable: every scenario */
+/* runs once that way and once with a custom invoke callback, which forces */
+/* the queued path, and the invocation orders must match */
+#define MAXLOG 64
+
+static ev_prepare prepares[5];
+static ev_check checks[3];
+static ev_idle idles[3];
+static ev_idle fed;
+static int log_buf[MAXLOG];
+static int log_len;
+
+static void die(const char* msg) {
+  fprintf(stderr, "%s\n", msg);
+  exit(EXIT_FAILURE);
+}
+
+static void note(int id) {
+  if (log_len == MAXLOG)
+    die("invocation log overflow");
+
+  log_buf[log_len++] = id;
+}
+
+static void prepare_cb(EV_P_ ev_prepare* w, int revents) {
+  int i = (int)(w - prepares);
+
+  if (!(revents & EV_PREPARE))
+    die("prepare callback without EV_PREPARE");
+
+  note(10 + i);
+
+  /* stop one that has not run yet, start one that must not run this time */
+  if (i == 3) {
+    ev_prepare_stop(EV_A_ & prepares[1]);
+    ev_prepare_start(EV_A_ & prepares[4]);
+  }
+
+  /* queue another event, the remaining prepares run after it */
+  if (i == 2)
+    ev_feed_event(EV_A_ & fed, EV_CUSTOM);
+}
+
+static void check_cb(EV_P_ ev_check* w, int revents) {
+  int i = (int)(w - checks);
+
+  if (!(revents & EV_CHECK))
+    die("check callback without EV_CHECK");
+
+  note(20 + i);
+
+  if (i == 2) {
+    ev_idle_stop(EV_A_ & idles[0]);
+
+    /* the checks and idles yet to run are pending, and can be cancelled */
+    note(50 + ev_pending_count(EV_A));
+    note(ev_is_pending(&checks[0]) ? 71 : 70);
+    note(ev_clear_pending(EV_A_ & checks[1]) == EV_CHECK ? 61 : 60);
+  }
+}
+
+static void idle_cb(EV_P_ ev_idle* w, int revents) {
+  int i = (int)(w - idles);
+
+  (void)loop;
+
+  if (!(revents & EV_IDLE))
+    die("idle callback without EV_IDLE");
+
+  note(30 + i);
+}
+
+static void fed_cb(EV_P_ ev_idle* w, int revents) {
+  (void)loop;
+  (void)w;
+  (void)revents;
+
+  note(40);
+}
+
+static void queued_invoke(EV_P) {
+  ev_invoke_pending(EV_A);
+}
+
+static int run_scenario(int queued, int* out) {
+  struct ev_loop* loop = ev_loop_new(EVFLAG_AUTO);
+  int i;
+
+  if (!loop)
+    die("ev_loop_new failed");
+
+  if (queued)
+    ev_set_invoke_pending_cb(loop, queued_invoke);
+
+  for (i = 0; i < 5; ++i)
+    ev_prepare_init(&prepares[i], prepare_cb);
+
+  for (i = 0; i < 3; ++i) {
+    ev_check_init(&checks[i], check_cb);
+    ev_idle_init(&idles[i], idle_cb);
+  }
+
+  ev_idle_init(&fed, fed_cb);
+
+  for (i = 0; i < 4; ++i)
+    ev_prepare_start(loop, &prepares[i]);
+
+  for (i = 0; i < 3; ++i) {
+    ev_check_start(loop, &checks[i]);
+    ev_idle_start(loop, &idles[i]);
+  }
+
+  log_len = 0;
+
+  /* two iterations: the second one runs without the prepare side effects */
+  ev_run(loop, EVRUN_NOWAIT);
+  ev_run(loop, EVRUN_NOWAIT);
+  ev_verify(loop);
+
+  for (i = 0; i < 5; ++i)
+    ev_prepare_stop(loop, &prepares[i]);
+
+  for (i = 0; i < 3; ++i) {
+    ev_check_stop(loop, &checks[i]);
+    ev_idle_stop(loop, &idles[i]);
+  }
+
+  ev_loop_destroy(loop);
+
+  memcpy(out, log_buf, sizeof(int) * log_len);
+  return log_len;
+}
+
+int main(void) {
+  int direct[MAXLOG];
+  int queued[MAXLOG];
+  int ndirect = run_scenario(0, direct);
+  int nqueued = run_scenario(1, queued);
+  int i;
+
+  if (ndirect != nqueued || memcmp(direct, queued, sizeof(int) * ndirect)) {
+    for (i = 0; i < ndirect; ++i)
+      fprintf(stderr, " %d", direct[i]);
+    fprintf(stderr, " (direct)\n");
+
+    for (i = 0; i < nqueued; ++i)
+      fprintf(stderr, " %d", queued[i]);
+    fprintf(stderr, " (queued)\n");
+
+    die("direct invocation order differs from the queued one");
+  }
+
+  return EXIT_SUCCESS;
+}
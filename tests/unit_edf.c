@@ -0,0 +1,169 @@
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "ev.h"
+
+#define BULK 8
+
+static ev_idle bulk[BULK];
+static ev_idle urgent;
+static ev_idle clearer;
+static ev_idle refeeder;
+static ev_idle* order[BULK + 4];
+static int invoked;
+static int refeeds;
+static int runs[BULK];
+
+static void die(const char* msg) {
+  fprintf(stderr, "%s\n", msg);
+  exit(EXIT_FAILURE);
+}
+
+static void record_cb(EV_P_ ev_idle* w, int revents) {
+  (void)loop;
+  (void)revents;
+
+  order[invoked++] = w;
+}
+
+static void clearer_cb(EV_P_ ev_idle* w, int revents) {
+  record_cb(EV_A_ w, revents);
+
+  if (!ev_clear_pending(EV_A_ & bulk[0]))
+    die("queued watcher was not pending during the edf round");
+}
+
+static void refeeder_cb(EV_P_ ev_idle* w, int revents) {
+  record_cb(EV_A_ w, revents);
+
+  /* queued again for the next round, must still run in this ev_invoke_pending */
+  if (++refeeds < 3)
+    ev_feed_event(EV_A_ w, EV_CUSTOM);
+}
+
+/* invokes pendings from within the edf round that invokes it */
+static void nester_cb(EV_P_ ev_idle* w, int revents) {
+  record_cb(EV_A_ w, revents);
+  ev_invoke_pending(EV_A);
+}
+
+static void counter_cb(EV_P_ ev_idle* w, int revents) {
+  record_cb(EV_A_ w, revents);
+  ++runs[w - bulk];
+}
+
+static void reset(void) {
+  invoked = 0;
+  refeeds = 0;
+}
+
+int main(void) {
+  struct ev_loop* loop = ev_loop_new(EVFLAG_AUTO);
+  int i;
+
+  if (!loop)
+    die("ev_loop_new failed");
+
+  for (i = 0; i < BULK; ++i) {
+    ev_idle_init(&bulk[i], record_cb);
+    ev_set_priority(&bulk[i], EV_MAXPRI);
+  }
+
+  ev_idle_init(&urgent, record_cb);
+  ev_set_priority(&urgent, EV_MINPRI);
+  ev_idle_init(&clearer, clearer_cb);
+  ev_idle_init(&refeeder, refeeder_cb);
+
+  /* a tight budget on a low priority beats a loose one on a high priority */
+  ev_set_priority_deadline(loop, EV_MAXPRI, 1.);
+  ev_set_priority_deadline(loop, EV_MINPRI, 0.001);
+
+  reset();
+  for (i = 0; i < BULK; ++i)
+    ev_feed_event(loop, &bulk[i], EV_CUSTOM);
+  ev_feed_event(loop, &urgent, EV_CUSTOM);
+  ev_invoke_pending(loop);
+
+  if (invoked != BULK + 1 || order[0] != &urgent)
+    die("edf did not run the earliest deadline first");
+
+  /* explicit deadlines, re-feeding keeps the earlier one */
+  reset();
+  ev_feed_event(loop, &bulk[0], EV_CUSTOM);
+  ev_feed_event_deadline(loop, &bulk[1], EV_CUSTOM, ev_now(loop) - 2.);
+  ev_feed_event_deadline(loop, &bulk[2], EV_CUSTOM, ev_now(loop) - 1.);
+  ev_feed_event_deadline(loop, &bulk[1], EV_CUSTOM, ev_now(loop) + 5.);
+  ev_invoke_pending(loop);
+
+  if (invoked != 3 || order[0] != &bulk[1] || order[1] != &bulk[2] || order[2] != &bulk[0])
+    die("explicit deadlines were not honoured");
+
+  /* cleared and re-fed watchers during a round */
+  reset();
+  ev_feed_event_deadline(loop, &clearer, EV_CUSTOM, ev_now(loop) - 1.);
+  ev_feed_event(loop, &bulk[0], EV_CUSTOM);
+  ev_feed_event(loop, &refeeder, EV_CUSTOM);
+  ev_invoke_pending(loop);
+  ev_verify(loop);
+
+  if (invoked != 4 || order[0] != &clearer || refeeds != 3)
+    die("cleared or re-fed watchers were mishandled");
+
+  if (ev_pending_count(loop))
+    die("edf round left stale pending entries");
+
+  /* an exhausted invoke budget keeps the rest pending and correctly indexed */
+  reset();
+  ev_set_invoke_budget(loop, 2, 0.);
+  for (i = 0; i < BULK; ++i)
+    ev_feed_event_deadline(loop, &bulk[i], EV_CUSTOM, ev_now(loop) + i);
+  ev_invoke_pending(loop);
+  ev_verify(loop);
+
+  if (invoked != 2 || order[0] != &bulk[0] || order[1] != &bulk[1])
+    die("budgeted edf round invoked the wrong watchers");
+
+  if (ev_pending_count(loop) != BULK - 2 || ev_clear_pending(loop, &bulk[BULK - 1]) != EV_CUSTOM)
+    die("budgeted edf round lost the remaining watchers");
+
+  ev_set_invoke_budget(loop, 0, 0.);
+  ev_invoke_pending(loop);
+
+  if (invoked != BULK - 1 || order[2] != &bulk[2])
+    die("deferred edf watchers did not run in deadline order");
+
+  /* explicit deadlines fed while edf is off survive turning it on */
+  reset();
+  ev_set_priority_deadline(loop, EV_MAXPRI, 0.);
+  ev_set_priority_deadline(loop, EV_MINPRI, 0.);
+  ev_feed_event_deadline(loop, &bulk[0], EV_CUSTOM, ev_now(loop) - 10.);
+  ev_feed_event(loop, &bulk[1], EV_CUSTOM);
+  ev_set_priority_deadline(loop, EV_MAXPRI, 1.);
+  ev_invoke_pending(loop);
+
+  if (invoked != 2 || order[0] != &bulk[0] || order[1] != &bulk[1])
+    die("enabling edf overwrote an explicit deadline");
+
+  /* a nested pass while the budget is exhausted must not leave a stale heap behind */
+  reset();
+  ev_set_invoke_budget(loop, 2, 0.);
+  for (i = 0; i < 6; ++i) {
+    ev_set_cb(&bulk[i], i ? counter_cb : nester_cb);
+    ev_feed_event_deadline(loop, &bulk[i], EV_CUSTOM, ev_now(loop) + i);
+  }
+  for (i = 0; i < 6 && ev_pending_count(loop); ++i) {
+    ev_invoke_pending(loop);
+    ev_verify(loop);
+  }
+
+  if (invoked != 6 || order[0] != &bulk[0] || order[1] != &bulk[1] || order[2] != &bulk[2])
+    die("nested edf pass invoked the wrong watchers");
+
+  for (i = 1; i < 6; ++i)
+    if (runs[i] != 1)
+      die("nested edf pass invoked a watcher twice");
+
+  ev_loop_destroy(loop);
+
+  return EXIT_SUCCESS;
+}
@@ -5,8 +5,13 @@
 
 #include "ev.h"
 
+#define CHAIN 1000
+#define BURST 200
+
 static int once_called;
 static int once_revents;
+static long alloc_calls;
+static int chained;
 
 static void die(const char* msg) {
   perror(msg);
@@ -21,8 +26,123 @@ static void once_cb(int revents, void* arg) {
   ev_break((struct ev_loop*)arg, EVBREAK_ALL);
 }
 
+static void* counting_alloc(void* ptr, long size) {
+  ++alloc_calls;
+
+  if (!size) {
+    free(ptr);
+    return 0;
+  }
+
+  return realloc(ptr, size);
+}
+
+/* every callback issues the next one-shot, which reuses the block just freed */
+static void chain_cb(int revents, void* arg) {
+  (void)revents;
+
+  if (++chained < CHAIN)
+    ev_once((struct ev_loop*)arg, -1, 0, 0., chain_cb, arg);
+}
+
+static void count_cb(int revents, void* arg) {
+  (void)revents;
+  (void)arg;
+
+  ++chained;
+}
+
+/* caller storage may be released by its own callback */
+static void storage_cb(int revents, void* arg) {
+  once_called++;
+  once_revents = revents;
+  free(arg);
+}
+
+static void test_pooled(struct ev_loop* loop) {
+  long before;
+  int i;
+
+  /* the first slab, then no more allocations as long as blocks come back */
+  ev_once(loop, -1, 0, 0., count_cb, 0);
+  ev_run(loop, 0);
+
+  before = alloc_calls;
+  chained = 0;
+  ev_once(loop, -1, 0, 0., chain_cb, loop);
+  ev_run(loop, 0);
+
+  if (chained != CHAIN)
+    die("chained ev_once");
+
+  /* many outstanding at once take more slabs, which are kept afterwards */
+  chained = 0;
+
+  for (i = 0; i < BURST; ++i)
+    ev_once(loop, -1, 0, 0., count_cb, 0);
+
+  ev_run(loop, 0);
+
+  if (chained != BURST || alloc_calls == before)
+    die("burst of ev_once");
+
+  before = alloc_calls;
+  chained = 0;
+
+  for (i = 0; i < BURST; ++i)
+    ev_once(loop, -1, 0, 0., count_cb, 0);
+
+  ev_run(loop, 0);
+
+  if (chained != BURST || alloc_calls != before)
+    die("ev_once blocks were not reused");
+}
+
+static void test_caller_storage(struct ev_loop* loop) {
+  long before = 0;
+  int fds[2];
+  int round;
+  char c;
+
+  if (pipe(fds))
+    die("pipe");
+
+  /* the first round may still grow the fd tables, the second must not allocate */
+  for (round = 0; round < 2; ++round) {
+    ev_once_storage* once = (ev_once_storage*)malloc(sizeof(ev_once_storage));
+
+    if (!once)
+      die("malloc");
+
+    if (write(fds[1], "x", 1) != 1)
+      die("write");
+
+    before = alloc_calls;
+    once_called = 0;
+    once_revents = 0;
+    ev_once_start(loop, once, fds[0], EV_READ, 10., storage_cb, once);
+    ev_run(loop, 0);
+
+    if (once_called != 1 || !(once_revents & EV_READ) || (once_revents & EV_TIMEOUT))
+      die("ev_once_start");
+
+    if (read(fds[0], &c, 1) != 1)
+      die("read");
+  }
+
+  if (alloc_calls != before)
+    die("ev_once_start allocated memory");
+
+  close(fds[0]);
+  close(fds[1]);
+}
+
 int main(void) {
-  struct ev_loop* loop = ev_default_loop(EVFLAG_AUTO);
+  struct ev_loop* loop;
+
+  ev_set_allocator(counting_alloc);
+
+  loop = ev_default_loop(EVFLAG_AUTO);
   if (!loop)
     die("ev_default_loop");
 
@@ -33,5 +153,8 @@ int main(void) {
   if (once_called != 1 || !(once_revents & EV_TIMEOUT))
     die("ev_once");
 
+  test_pooled(loop);
+  test_caller_storage(loop);
+
   return EXIT_SUCCESS;
 }
@@ -0,0 +1,115 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include "ev.h"
+
+/* fd_ebadf and fd_rearm_all only visit fds in the index of watched fds, */
+/* so it has to follow watchers being started, stopped and killed */
+#define FDS 6
+
+static ev_io ios[FDS];
+static int pipes[FDS][2];
+static int reads[FDS];
+static int errors[FDS];
+
+static void die(const char* msg) {
+  fprintf(stderr, "%s\n", msg);
+  exit(EXIT_FAILURE);
+}
+
+static void io_cb(EV_P_ ev_io* w, int revents) {
+  int i = (int)(w - ios);
+  char c;
+
+  (void)loop;
+
+  if (revents & EV_ERROR) {
+    ++errors[i];
+    return;
+  }
+
+  if (read(ev_io_fd(w), &c, 1) != 1)
+    die("io callback without data");
+
+  ++reads[i];
+}
+
+static void poke(int i) {
+  if (write(pipes[i][1], "x", 1) != 1)
+    die("write failed");
+}
+
+static void test_ebadf(void) {
+  struct ev_loop* loop = ev_loop_new(EVBACKEND_SELECT);
+  int i;
+
+  if (!loop)
+    return; /* no select backend */
+
+  for (i = 0; i < FDS; ++i) {
+    if (pipe(pipes[i]))
+      die("pipe failed");
+
+    ev_io_init(&ios[i], io_cb, pipes[i][0], EV_READ);
+    ev_io_start(loop, &ios[i]);
+  }
+
+  /* a stopped fd drops out of the index once reified */
+  ev_io_stop(loop, &ios[1]);
+  ev_run(loop, EVRUN_NOWAIT);
+
+  /* closing a watched fd behind our back makes select fail with EBADF */
+  close(pipes[3][0]);
+  close(pipes[3][1]);
+
+  for (i = 0; i < FDS; ++i)
+    if (i != 3)
+      poke(i);
+
+  ev_run(loop, EVRUN_NOWAIT);
+  ev_run(loop, EVRUN_NOWAIT);
+
+  if (errors[3] != 1 || ev_is_active(&ios[3]))
+    die("watcher on a closed fd was not killed");
+
+  for (i = 0; i < FDS; ++i)
+    if (i != 3 && errors[i])
+      die("watcher on a valid fd got EV_ERROR");
+
+  if (reads[1])
+    die("stopped watcher was invoked");
+
+  for (i = 0; i < FDS; ++i)
+    if (i != 1 && i != 3 && reads[i] != 1)
+      die("watcher on a valid fd missed its event");
+
+  /* the killed and the stopped fd can come back */
+  if (pipe(pipes[3]))
+    die("pipe failed");
+
+  ev_io_set(&ios[3], pipes[3][0], EV_READ);
+  ev_io_start(loop, &ios[3]);
+  ev_io_start(loop, &ios[1]);
+  poke(3);
+  ev_run(loop, EVRUN_NOWAIT);
+
+  if (reads[1] != 1 || reads[3] != 1)
+    die("restarted watchers missed their events");
+
+  ev_verify(loop);
+
+  for (i = 0; i < FDS; ++i) {
+    ev_io_stop(loop, &ios[i]);
+    close(pipes[i][0]);
+    close(pipes[i][1]);
+  }
+
+  ev_loop_destroy(loop);
+}
+
+int main(void) {
+  test_ebadf();
+
+  return EXIT_SUCCESS;
+}
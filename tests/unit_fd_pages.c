@@ -0,0 +1,115 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/resource.h>
+#include <unistd.h>
+
+#include "ev.h"
+
+/* watchers on a few fds far apart, so that a paged fd table (EV_FD_PAGES) */
+/* has to deal with pages that were never touched between them */
+#define FDS 4
+
+static ev_io ios[FDS];
+static int rfds[FDS];
+static int wfds[FDS];
+static int fired[FDS];
+
+static void die(const char* msg) {
+  fprintf(stderr, "%s\n", msg);
+  exit(EXIT_FAILURE);
+}
+
+static void read_cb(EV_P_ ev_io* w, int revents) {
+  int i = (int)(w - ios);
+  char c;
+
+  (void)loop;
+
+  if (!(revents & EV_READ))
+    die("io callback without EV_READ");
+
+  if (read(ev_io_fd(w), &c, 1) != 1)
+    die("io callback without data");
+
+  ++fired[i];
+}
+
+static void write_all(void) {
+  int i;
+
+  for (i = 0; i < FDS; ++i)
+    if (write(wfds[i], "x", 1) != 1)
+      die("write failed");
+}
+
+static void expect_all(int count) {
+  int i;
+
+  for (i = 0; i < FDS; ++i)
+    if (fired[i] != count)
+      die("io watcher on a sparse fd did not fire");
+}
+
+int main(void) {
+  struct ev_loop* loop = ev_loop_new(EVFLAG_AUTO);
+  struct rlimit rl;
+  int high, i;
+
+  if (!loop)
+    die("ev_loop_new failed");
+
+  if (getrlimit(RLIMIT_NOFILE, &rl) || rl.rlim_cur < 4096)
+    return EXIT_SUCCESS; /* not enough fds for a sparse layout */
+
+  high = rl.rlim_cur > 65536 ? 65535 : (int)rl.rlim_cur - 1;
+
+  for (i = 0; i < FDS; ++i) {
+    int p[2];
+
+    if (pipe(p))
+      die("pipe failed");
+
+    /* one low fd, the others spread up to the limit */
+    rfds[i] = i ? high - (FDS - 1 - i) * (high / FDS) : p[0];
+
+    if (i) {
+      if (dup2(p[0], rfds[i]) != rfds[i])
+        die("dup2 failed");
+
+      close(p[0]);
+    }
+
+    wfds[i] = p[1];
+    ev_io_init(&ios[i], read_cb, rfds[i], EV_READ);
+    ev_io_start(loop, &ios[i]);
+  }
+
+  write_all();
+  ev_run(loop, EVRUN_NOWAIT);
+  expect_all(1);
+
+  /* re-arms every fd from scratch */
+  ev_loop_fork(loop);
+  write_all();
+  ev_run(loop, EVRUN_NOWAIT);
+  expect_all(2);
+
+  /* stop and restart the highest fd, its slot must come back clean */
+  ev_io_stop(loop, &ios[FDS - 1]);
+  ev_io_start(loop, &ios[FDS - 1]);
+  write_all();
+  ev_run(loop, EVRUN_NOWAIT);
+  expect_all(3);
+
+  ev_verify(loop);
+
+  for (i = 0; i < FDS; ++i) {
+    ev_io_stop(loop, &ios[i]);
+    close(rfds[i]);
+    close(wfds[i]);
+  }
+
+  ev_loop_destroy(loop);
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,117 @@
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "ev.h"
+
+/* with EVFLAG_HUGEPAGES/EVFLAG_NUMALOCAL, the timer heap and fd table move */
+/* into their own mappings once they get large, and back when trimmed; */
+/* reservations push them over the threshold without that many watchers */
+#define TIMERS 2000
+#define HUGE_TIMERS (1 << 18)
+#define HUGE_FDS 200000
+
+static ev_timer timers[TIMERS];
+static ev_tstamp last_at;
+static int fired;
+
+static void die(const char* msg) {
+  fprintf(stderr, "%s\n", msg);
+  exit(EXIT_FAILURE);
+}
+
+static void* plain_alloc(void* ptr, long size, void* ctx) {
+  (void)ctx;
+
+  if (!size) {
+    free(ptr);
+    return 0;
+  }
+
+  return realloc(ptr, size);
+}
+
+static void timer_cb(EV_P_ ev_timer* w, int revents) {
+  (void)loop;
+  (void)revents;
+
+  if (w->at < last_at)
+    die("timers fired out of order");
+
+  last_at = w->at;
+  ++fired;
+}
+
+static void run_timers(struct ev_loop* loop) {
+  int i;
+
+  /* a scattered order, so the heap gets shuffled while it is remapped */
+  for (i = 0; i < TIMERS; ++i) {
+    ev_timer_init(&timers[i], timer_cb, -1. + ((i * 7919L) % TIMERS) * 1e-6, 0.);
+    ev_timer_start(loop, &timers[i]);
+  }
+
+  for (i = 0; i < TIMERS; i += 3)
+    ev_timer_stop(loop, &timers[i]);
+
+  ev_verify(loop);
+
+  last_at = -1e30;
+  fired = 0;
+  ev_run(loop, EVRUN_NOWAIT);
+
+  if (fired != TIMERS - (TIMERS + 2) / 3)
+    die("not all timers fired");
+}
+
+static void test_flags(unsigned int flags, int own_allocator) {
+  struct ev_loop* loop =
+      own_allocator ? ev_loop_new_with_allocator(flags, plain_alloc, 0) : ev_loop_new(flags);
+  int i;
+
+  if (!loop)
+    die("ev_loop_new failed");
+
+  run_timers(loop);
+
+  /* from malloc into a mapping, and from one mapping into a larger one, */
+  /* with live timers in the heap each time */
+  for (i = 0; i < TIMERS; ++i)
+    ev_timer_start(loop, &timers[i]);
+
+  ev_loop_reserve(loop, 0, HUGE_TIMERS, 0);
+  ev_verify(loop);
+  ev_loop_reserve(loop, 0, HUGE_TIMERS * 2, 0);
+  ev_verify(loop);
+
+  for (i = 0; i < TIMERS; ++i)
+    ev_timer_stop(loop, &timers[i]);
+
+  run_timers(loop);
+
+  /* a smaller reservation lets trimming go back below the huge page threshold */
+  ev_loop_reserve(loop, 0, 1, 0);
+  ev_loop_trim(loop);
+  ev_verify(loop);
+  run_timers(loop);
+
+  /* a large fd table, without needing that many fds */
+  ev_loop_reserve(loop, HUGE_FDS, 0, 0);
+
+  for (i = 0; i < HUGE_FDS; i += 997)
+    ev_feed_fd_event(loop, i, EV_READ);
+
+  ev_run(loop, EVRUN_NOWAIT);
+  ev_verify(loop);
+
+  ev_loop_destroy(loop);
+}
+
+int main(void) {
+  test_flags(EVFLAG_AUTO, 0);
+  test_flags(EVFLAG_HUGEPAGES, 0);
+  test_flags(EVFLAG_NUMALOCAL, 0);
+  test_flags(EVFLAG_HUGEPAGES | EVFLAG_NUMALOCAL, 0);
+  test_flags(EVFLAG_HUGEPAGES | EVFLAG_NUMALOCAL, 1);
+
+  return EXIT_SUCCESS;
+}
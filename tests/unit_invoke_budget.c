@@ -0,0 +1,99 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "ev.h"
+
+#define BURST 100
+#define BUDGET 10
+
+static ev_idle burst[BURST];
+static int burst_done;
+static int io_seen_at = -1;
+static int fds[2];
+
+static void die(const char* msg) {
+  fprintf(stderr, "%s\n", msg);
+  exit(EXIT_FAILURE);
+}
+
+static void burst_cb(EV_P_ ev_idle* w, int revents) {
+  (void)w;
+  (void)revents;
+
+  /* make high priority io ready behind the queued burst */
+  if (++burst_done == 1 && write(fds[1], "x", 1) != 1)
+    die("write failed");
+
+  if (burst_done == BURST)
+    ev_break(EV_A_ EVBREAK_ALL);
+}
+
+static void io_cb(EV_P_ ev_io* w, int revents) {
+  char c;
+
+  (void)loop;
+  (void)revents;
+
+  if (read(ev_io_fd(w), &c, 1) != 1)
+    die("io callback without data");
+
+  io_seen_at = burst_done;
+}
+
+int main(void) {
+  struct ev_loop* loop = ev_loop_new(EVFLAG_AUTO);
+  ev_io io;
+  int i;
+
+  if (!loop)
+    die("ev_loop_new failed");
+
+  if (socketpair(AF_UNIX, SOCK_STREAM, 0, fds))
+    die("socketpair failed");
+
+  ev_io_init(&io, io_cb, fds[0], EV_READ);
+  ev_set_priority(&io, EV_MAXPRI);
+  ev_io_start(loop, &io);
+
+  ev_set_invoke_budget(loop, BUDGET, 0.);
+
+  for (i = 0; i < BURST; ++i) {
+    ev_idle_init(&burst[i], burst_cb);
+    ev_set_priority(&burst[i], EV_MINPRI);
+    ev_feed_event(loop, &burst[i], EV_CUSTOM);
+  }
+
+  ev_run(loop, 0);
+
+  if (burst_done != BURST)
+    die("deferred callbacks were lost");
+
+  if (io_seen_at < 0 || io_seen_at > BUDGET)
+    die("io was starved by the burst despite the budget");
+
+  if (!ev_invoke_deferred(loop))
+    die("deferred callbacks were not counted");
+
+  /* without a budget the whole burst runs before polling again */
+  ev_set_invoke_budget(loop, 0, 0.);
+  burst_done = 0;
+  io_seen_at = -1;
+
+  for (i = 0; i < BURST; ++i)
+    ev_feed_event(loop, &burst[i], EV_CUSTOM);
+
+  ev_run(loop, 0);
+
+  if (io_seen_at != -1)
+    die("unbudgeted invoke polled in the middle of the burst");
+
+  ev_io_stop(loop, &io);
+  ev_loop_destroy(loop);
+
+  close(fds[0]);
+  close(fds[1]);
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,196 @@
+#include <dirent.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include "ev.h"
+
+static struct ev_loop* loop_a;
+static struct ev_loop* loop_b;
+static ev_io first;
+static ev_io second;
+static ev_async wakeup;
+static int hits_a;
+static int hits_b;
+static int last_revents;
+
+static void die(const char* msg) {
+  fprintf(stderr, "%s\n", msg);
+  exit(EXIT_FAILURE);
+}
+
+static void io_cb(EV_P_ ev_io* w, int revents) {
+  (void)w;
+
+  if (EV_A == loop_a)
+    ++hits_a;
+  else if (EV_A == loop_b)
+    ++hits_b;
+  else
+    die("io callback invoked in an unknown loop");
+
+  last_revents = revents;
+}
+
+static void migrating_cb(EV_P_ ev_io* w, int revents) {
+  io_cb(EV_A_ w, revents);
+
+  /* the other watcher is pending in this iteration as well, its event must come along */
+  if (EV_A == loop_a && ev_io_migrate(EV_A_ ev_io_fd(w), loop_b) != 2)
+    die("ev_io_migrate did not move both watchers");
+}
+
+/* how many epoll sets of this process hold fd, -1 where that cannot be told */
+static int epoll_sets_with(int fd) {
+  char path[320];
+  char line[256];
+  struct dirent* d;
+  DIR* dir = opendir("/proc/self/fdinfo");
+  int count = 0;
+  int tfd;
+
+  if (!dir)
+    return -1;
+
+  while ((d = readdir(dir))) {
+    FILE* f;
+    int found = 0;
+
+    if (d->d_name[0] == '.')
+      continue;
+
+    snprintf(path, sizeof(path), "/proc/self/fdinfo/%s", d->d_name);
+
+    if (!(f = fopen(path, "r")))
+      continue;
+
+    while (fgets(line, sizeof(line), f))
+      if (sscanf(line, "tfd: %d", &tfd) == 1 && tfd == fd)
+        found = 1;
+
+    fclose(f);
+    count += found;
+  }
+
+  closedir(dir);
+
+  return count;
+}
+
+static void async_cb(EV_P_ ev_async* w, int revents) {
+  (void)loop;
+  (void)w;
+  (void)revents;
+}
+
+static void test_carries_pending_events(int fds[2]) {
+  hits_a = hits_b = 0;
+
+  ev_io_init(&first, io_cb, fds[0], EV_READ);
+  ev_io_init(&second, io_cb, fds[0], EV_READ);
+  ev_io_start(loop_a, &first);
+  ev_io_start(loop_a, &second);
+
+  /* the pipe is empty, so only the carried events can make the watchers fire */
+  ev_feed_fd_event(loop_a, fds[0], EV_READ);
+
+  if (ev_io_migrate(loop_a, fds[0], loop_b) != 2)
+    die("ev_io_migrate did not move both watchers");
+
+  if (ev_is_active(&first) || ev_is_pending(&first) || ev_is_pending(&second))
+    die("migrated watcher still active or pending in the source loop");
+
+  ev_run(loop_a, EVRUN_NOWAIT);
+  ev_run(loop_b, EVRUN_NOWAIT);
+
+  if (hits_a || hits_b != 2 || last_revents != EV_READ)
+    die("pending events were not carried to the target loop");
+
+  if (!ev_is_active(&first) || !ev_is_active(&second))
+    die("migrated watchers are not active in the target loop");
+
+  ev_io_stop(loop_b, &first);
+  ev_io_stop(loop_b, &second);
+}
+
+static void test_migrate_from_callback(int fds[2]) {
+  hits_a = hits_b = 0;
+
+  ev_io_init(&first, migrating_cb, fds[0], EV_READ);
+  ev_io_init(&second, migrating_cb, fds[0], EV_READ);
+  ev_io_start(loop_a, &first);
+  ev_io_start(loop_a, &second);
+
+  if (write(fds[1], "x", 1) != 1)
+    die("write failed");
+
+  ev_run(loop_a, EVRUN_NOWAIT);
+
+  if (hits_a != 1)
+    die("migrating callback did not run exactly once in the source loop");
+
+
+  /* the first run delivers the carried event, the second the fd readiness */
+  ev_run(loop_b, EVRUN_NOWAIT);
+  ev_run(loop_b, EVRUN_NOWAIT);
+
+  if (hits_a != 1 || hits_b < 2)
+    die("migrated watchers did not fire in the target loop");
+
+  /* only the target loop may still poll the fd */
+  if (ev_backend(loop_a) == EVBACKEND_EPOLL && ev_backend(loop_b) == EVBACKEND_EPOLL && epoll_sets_with(fds[0]) > 1)
+    die("migrated fd is still in the source loop's epoll set");
+
+  ev_run(loop_a, EVRUN_NOWAIT);
+
+  if (hits_a != 1)
+    die("migrated watcher still fires in the source loop");
+
+  ev_io_stop(loop_b, &first);
+  ev_io_stop(loop_b, &second);
+}
+
+static void test_target_needs_wakeup(int fds[2]) {
+  struct ev_loop* plain = ev_loop_new(EVFLAG_AUTO);
+
+  ev_io_init(&first, io_cb, fds[0], EV_READ);
+  ev_io_start(loop_a, &first);
+
+  if (ev_io_migrate(loop_a, fds[0], plain) != -1)
+    die("migration to a loop without wakeup pipe was accepted");
+
+  if (!ev_is_active(&first))
+    die("failed migration stopped the watcher");
+
+  ev_io_stop(loop_a, &first);
+  ev_loop_destroy(plain);
+}
+
+int main(void) {
+  int fds[2];
+
+  loop_a = ev_loop_new(EVFLAG_AUTO);
+  loop_b = ev_loop_new(EVFLAG_AUTO);
+
+  if (!loop_a || !loop_b)
+    die("ev_loop_new failed");
+
+  if (pipe(fds))
+    die("pipe failed");
+
+  /* gives loop_b the wakeup pipe migrations are delivered through */
+  ev_async_init(&wakeup, async_cb);
+  ev_async_start(loop_b, &wakeup);
+
+  test_carries_pending_events(fds);
+  test_migrate_from_callback(fds);
+  test_target_needs_wakeup(fds);
+
+  ev_async_stop(loop_b, &wakeup);
+  ev_loop_destroy(loop_b);
+  ev_loop_destroy(loop_a);
+  close(fds[0]);
+  close(fds[1]);
+
+  return EXIT_SUCCESS;
+}
@@ -125,10 +125,61 @@ static void test_io_ev_iofdset_bookkeeping(void) {
     close(fds[1]);
 }
 
+static void test_io_mixed_reader_writer_counts(void) {
+    struct ev_loop *loop = ev_default_loop(0);
+    int fds[2];
+    int reads = 0, writes = 0;
+    ev_io readers[3], writers[2];
+    int i;
+    
+    assert(socketpair(AF_UNIX, SOCK_STREAM, 0, fds) == 0);
+    fcntl(fds[0], F_SETFL, O_NONBLOCK);
+    
+    for (i = 0; i < 3; ++i) {
+        ev_io_init(&readers[i], io_cb, fds[0], EV_READ);
+        readers[i].data = &reads;
+        ev_io_start(loop, &readers[i]);
+    }
+    
+    for (i = 0; i < 2; ++i) {
+        ev_io_init(&writers[i], io_cb, fds[0], EV_WRITE);
+        writers[i].data = &writes;
+        ev_io_start(loop, &writers[i]);
+    }
+    
+    // Dropping readers one by one keeps EV_READ in the mask until the last one is gone
+    write(fds[1], "x", 1);
+    ev_io_stop(loop, &readers[0]);
+    ev_io_stop(loop, &readers[1]);
+    ev_run(loop, EVRUN_NOWAIT);
+    assert(reads == 1);
+    assert(writes == 2);
+    
+    ev_io_stop(loop, &readers[2]);
+    ev_run(loop, EVRUN_NOWAIT);
+    assert(reads == 1);
+    assert(writes == 4);
+    
+    // With only a reader left, the socket being writable must not matter
+    ev_io_stop(loop, &writers[0]);
+    ev_io_stop(loop, &writers[1]);
+    ev_io_start(loop, &readers[0]);
+    ev_run(loop, EVRUN_NOWAIT);
+    assert(reads == 2);
+    assert(writes == 4);
+    
+    ev_verify(loop);
+    ev_io_stop(loop, &readers[0]);
+    
+    close(fds[0]);
+    close(fds[1]);
+}
+
 int main(void) {
     test_io_start_stop_basic();
     test_io_multiple_watchers_same_fd();
     test_io_event_mask_clamping();
     test_io_ev_iofdset_bookkeeping();
+    test_io_mixed_reader_writer_counts();
     return 0;
 }
@@ -0,0 +1,164 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include "ev.h"
+
+/* everything a loop allocates goes through its own allocator, never the global one */
+#define TIMERS 1000
+
+typedef struct {
+  long live;
+  long calls;
+  void* first;
+} arena;
+
+static long global_calls;
+static ev_timer timers[TIMERS];
+static ev_idle idle;
+static int once_fired;
+
+static void die(const char* msg) {
+  fprintf(stderr, "%s\n", msg);
+  exit(EXIT_FAILURE);
+}
+
+static void* counting_alloc(void* ptr, long size, void* ctx) {
+  arena* a = (arena*)ctx;
+
+  ++a->calls;
+
+  if (!ptr && size)
+    ++a->live;
+  else if (ptr && !size)
+    --a->live;
+
+  if (!size) {
+    free(ptr);
+    return 0;
+  }
+
+  ptr = realloc(ptr, size);
+
+  if (!a->first)
+    a->first = ptr;
+
+  return ptr;
+}
+
+static void* global_alloc(void* ptr, long size) {
+  ++global_calls;
+
+  if (!size) {
+    free(ptr);
+    return 0;
+  }
+
+  return realloc(ptr, size);
+}
+
+static void timer_cb(EV_P_ ev_timer* w, int revents) {
+  (void)loop;
+  (void)w;
+  (void)revents;
+}
+
+static void io_cb(EV_P_ ev_io* w, int revents) {
+  (void)loop;
+  (void)w;
+  (void)revents;
+}
+
+static void idle_cb(EV_P_ ev_idle* w, int revents) {
+  (void)revents;
+
+  ev_idle_stop(EV_A_ w);
+}
+
+static void once_cb(int revents, void* arg) {
+  (void)revents;
+  (void)arg;
+
+  ++once_fired;
+}
+
+static void test_loop_allocator(void) {
+  arena a = {0, 0, 0};
+  struct ev_loop* loop;
+  long before;
+  int fds[2];
+  ev_io io;
+  int i;
+
+  ev_set_allocator(global_alloc);
+  before = global_calls;
+
+  loop = ev_loop_new_with_allocator(EVFLAG_AUTO, counting_alloc, &a);
+
+  if (!loop)
+    die("ev_loop_new_with_allocator failed");
+
+  if (a.first != (void*)loop)
+    die("the loop itself did not come from the loop allocator");
+
+  if (pipe(fds))
+    die("pipe failed");
+
+  /* grow the timer heap, pending arrays, fd tables and backend state */
+  for (i = 0; i < TIMERS; ++i) {
+    ev_timer_init(&timers[i], timer_cb, 0., 0.);
+    ev_timer_start(loop, &timers[i]);
+  }
+
+  ev_io_init(&io, io_cb, fds[0], EV_READ);
+  ev_io_start(loop, &io);
+  ev_idle_init(&idle, idle_cb);
+  ev_idle_start(loop, &idle);
+  ev_once(loop, -1, 0, 0., once_cb, 0);
+
+  ev_run(loop, EVRUN_NOWAIT);
+  ev_io_stop(loop, &io);
+  ev_run(loop, 0);
+
+  if (!once_fired)
+    die("ev_once did not fire");
+
+  ev_loop_destroy(loop);
+
+  if (global_calls != before)
+    die("loop memory went through the global allocator");
+
+  if (a.calls < 3)
+    die("loop allocator was hardly used");
+
+  if (a.live)
+    die("loop allocator leaked or double-freed");
+
+  close(fds[0]);
+  close(fds[1]);
+}
+
+static void test_default_allocator(void) {
+  struct ev_loop* loop;
+  long before;
+
+  /* without a loop allocator, loops keep using the global one */
+  before = global_calls;
+
+  loop = ev_loop_new(EVFLAG_AUTO);
+
+  if (!loop)
+    die("ev_loop_new failed");
+
+  ev_loop_destroy(loop);
+
+  if (global_calls == before)
+    die("plain loop did not use the global allocator");
+}
+
+int main(void) {
+  test_loop_allocator();
+  test_default_allocator();
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,112 @@
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "ev.h"
+
+#define LOOPS 4
+#define CONNS 64
+
+static struct ev_loop_group* group;
+static int per_loop[LOOPS];
+static int handled;
+
+static void die(const char* msg) {
+  fprintf(stderr, "%s\n", msg);
+  exit(EXIT_FAILURE);
+}
+
+static void conn_cb(EV_P_ int fd, void* arg) {
+  int i;
+
+  if (arg != (void*)&handled)
+    die("conn_cb got the wrong argument");
+
+  for (i = 0; i < LOOPS; ++i)
+    if (ev_loop_group_loop(group, i) == EV_A)
+      break;
+
+  if (i == LOOPS)
+    die("conn_cb invoked in a foreign loop");
+
+  __atomic_add_fetch(&per_loop[i], 1, __ATOMIC_RELAXED);
+  close(fd);
+  __atomic_add_fetch(&handled, 1, __ATOMIC_RELEASE);
+}
+
+static int new_fd(int* peer) {
+  int sv[2];
+
+  if (socketpair(AF_UNIX, SOCK_STREAM, 0, sv))
+    die("socketpair failed");
+
+  *peer = sv[1];
+  return sv[0];
+}
+
+static void run_group(unsigned int flags) {
+  int peers[CONNS];
+  int i;
+
+  group = ev_loop_group_new(LOOPS, EVFLAG_AUTO, flags, conn_cb, &handled);
+
+  if (!group || ev_loop_group_count(group) != LOOPS)
+    die("ev_loop_group_new failed");
+
+  for (i = 0; i < LOOPS; ++i)
+    per_loop[i] = 0;
+
+  handled = 0;
+
+  /* dispatched before the threads run, so queued fds count towards the load */
+  for (i = 0; i < CONNS; ++i)
+    if (ev_loop_group_dispatch(group, new_fd(&peers[i])) < 0)
+      die("ev_loop_group_dispatch failed");
+
+  if (ev_loop_group_start(group))
+    die("ev_loop_group_start failed");
+
+  while (__atomic_load_n(&handled, __ATOMIC_ACQUIRE) < CONNS)
+    ev_sleep(0.001);
+
+  for (i = 0; i < LOOPS; ++i)
+    if (per_loop[i] != CONNS / LOOPS)
+      die("fds were not spread evenly over the loops");
+
+  ev_loop_group_destroy(group);
+
+  for (i = 0; i < CONNS; ++i)
+    close(peers[i]);
+}
+
+static void test_destroy_closes_queued(void) {
+  int peer, fd;
+
+  group = ev_loop_group_new(2, EVFLAG_AUTO, EVGROUP_ROUNDROBIN, conn_cb, &handled);
+
+  if (!group)
+    die("ev_loop_group_new failed");
+
+  fd = new_fd(&peer);
+
+  if (ev_loop_group_dispatch(group, fd) != 0)
+    die("round-robin dispatch did not start with loop 0");
+
+  ev_loop_group_destroy(group);
+
+  if (fcntl(fd, F_GETFD) != -1 || errno != EBADF)
+    die("queued fd was not closed by ev_loop_group_destroy");
+
+  close(peer);
+}
+
+int main(void) {
+  run_group(EVGROUP_ROUNDROBIN);
+  run_group(EVGROUP_LEASTLOADED | EVGROUP_PIN);
+  test_destroy_closes_queued();
+
+  return EXIT_SUCCESS;
+}
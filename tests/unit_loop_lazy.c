@@ -0,0 +1,159 @@
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include "ev.h"
+
+/* the async map, the inotify hash and the signalfd set only get allocated */
+/* once a loop uses them, and everything works the same from there on */
+
+typedef struct {
+  long live;
+  long bytes;
+} counter;
+
+static int async_fired;
+static int signal_fired;
+static int stat_fired;
+static ev_async aw;
+static ev_signal sw;
+static ev_stat stw;
+
+static void die(const char* msg) {
+  fprintf(stderr, "%s\n", msg);
+  exit(EXIT_FAILURE);
+}
+
+/* keeps the size in front of every block, so live bytes can be tracked */
+static void* counting_alloc(void* ptr, long size, void* ctx) {
+  counter* c = (counter*)ctx;
+  long* block = ptr ? (long*)ptr - 2 : 0;
+
+  if (block) {
+    c->bytes -= block[0];
+    --c->live;
+  }
+
+  if (!size) {
+    free(block);
+    return 0;
+  }
+
+  block = (long*)realloc(block, size + 2 * sizeof(long));
+
+  if (!block)
+    return 0;
+
+  block[0] = size;
+  c->bytes += size;
+  ++c->live;
+
+  return block + 2;
+}
+
+static void async_cb(EV_P_ ev_async* w, int revents) {
+  (void)revents;
+
+  ++async_fired;
+  ev_async_stop(EV_A_ w);
+}
+
+static void signal_cb(EV_P_ ev_signal* w, int revents) {
+  (void)revents;
+
+  ++signal_fired;
+  ev_signal_stop(EV_A_ w);
+}
+
+static void stat_cb(EV_P_ ev_stat* w, int revents) {
+  (void)revents;
+
+  ++stat_fired;
+  ev_stat_stop(EV_A_ w);
+}
+
+static void test_async(void) {
+  counter c = {0, 0};
+  struct ev_loop* loop = ev_loop_new_with_allocator(EVFLAG_AUTO, counting_alloc, &c);
+  long idle_bytes;
+
+  if (!loop)
+    die("ev_loop_new_with_allocator failed");
+
+  idle_bytes = c.bytes;
+
+  ev_async_init(&aw, async_cb);
+  ev_async_start(loop, &aw);
+
+  if (c.bytes <= idle_bytes)
+    die("async state was allocated before the first ev_async_start");
+
+  ev_async_send(loop, &aw);
+  ev_run(loop, 0);
+
+  if (async_fired != 1)
+    die("async watcher was not invoked");
+
+  ev_loop_destroy(loop);
+
+  if (c.live)
+    die("async state leaked");
+}
+
+static void test_signalfd(void) {
+  counter c = {0, 0};
+  struct ev_loop* loop = ev_loop_new_with_allocator(EVFLAG_SIGNALFD, counting_alloc, &c);
+
+  if (!loop)
+    die("ev_loop_new_with_allocator failed");
+
+  ev_signal_init(&sw, signal_cb, SIGUSR1);
+  ev_signal_start(loop, &sw);
+  raise(SIGUSR1);
+  ev_run(loop, 0);
+
+  if (signal_fired != 1)
+    die("signal watcher was not invoked");
+
+  ev_loop_destroy(loop);
+
+  if (c.live)
+    die("signal state leaked");
+}
+
+static void test_stat(void) {
+  counter c = {0, 0};
+  struct ev_loop* loop = ev_loop_new_with_allocator(EVFLAG_AUTO, counting_alloc, &c);
+  char path[] = "/tmp/unit_loop_lazy_XXXXXX";
+  int fd = mkstemp(path);
+
+  if (!loop || fd < 0)
+    die("setup failed");
+
+  ev_stat_init(&stw, stat_cb, path, 0.);
+  ev_stat_start(loop, &stw);
+
+  if (write(fd, "x", 1) != 1)
+    die("write failed");
+
+  close(fd);
+  ev_run(loop, 0);
+
+  if (stat_fired != 1)
+    die("stat watcher was not invoked");
+
+  unlink(path);
+  ev_loop_destroy(loop);
+
+  if (c.live)
+    die("stat state leaked");
+}
+
+int main(void) {
+  test_async();
+  test_signalfd();
+  test_stat();
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,188 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include "ev.h"
+
+/* ev_loop_reserve pre-sizes the loop so that no allocation happens up to the */
+/* reservation, ev_loop_trim gives back what a peak left behind, but not below it */
+#define RESERVED 4096
+#define PEAK 20000
+#define FDS 32
+
+typedef struct {
+  long calls;
+  long bytes;
+} counter;
+
+static ev_timer timers[PEAK];
+static ev_io ios[FDS];
+static int fds[FDS][2];
+static int fired;
+
+static void die(const char* msg) {
+  fprintf(stderr, "%s\n", msg);
+  exit(EXIT_FAILURE);
+}
+
+/* keeps the size in front of every block, so live bytes can be tracked */
+static void* counting_alloc(void* ptr, long size, void* ctx) {
+  counter* c = (counter*)ctx;
+  long* block = ptr ? (long*)ptr - 2 : 0;
+
+  ++c->calls;
+
+  if (block)
+    c->bytes -= block[0];
+
+  if (!size) {
+    free(block);
+    return 0;
+  }
+
+  block = (long*)realloc(block, size + 2 * sizeof(long));
+
+  if (!block)
+    return 0;
+
+  block[0] = size;
+  c->bytes += size;
+
+  return block + 2;
+}
+
+static void timer_cb(EV_P_ ev_timer* w, int revents) {
+  (void)loop;
+  (void)w;
+  (void)revents;
+
+  ++fired;
+}
+
+static void trimming_cb(EV_P_ ev_timer* w, int revents) {
+  (void)w;
+  (void)revents;
+
+  if (!fired++)
+    ev_loop_trim(EV_A);
+}
+
+static void io_cb(EV_P_ ev_io* w, int revents) {
+  (void)loop;
+  (void)w;
+  (void)revents;
+}
+
+static void start_and_feed(struct ev_loop* loop, int n, void (*cb)(EV_P_ ev_timer*, int)) {
+  int i;
+
+  for (i = 0; i < n; ++i) {
+    ev_timer_init(&timers[i], cb, 3600., 0.);
+    ev_timer_start(loop, &timers[i]);
+    ev_feed_event(loop, &timers[i], EV_TIMER);
+  }
+}
+
+static void stop_all(struct ev_loop* loop, int n) {
+  int i;
+
+  for (i = 0; i < n; ++i)
+    ev_timer_stop(loop, &timers[i]);
+}
+
+static void test_reserve_and_trim(void) {
+  counter c = {0, 0};
+  struct ev_loop* loop = ev_loop_new_with_allocator(EVFLAG_AUTO, counting_alloc, &c);
+  long calls, peak;
+  int i;
+
+  if (!loop)
+    die("ev_loop_new_with_allocator failed");
+
+  for (i = 0; i < FDS; ++i)
+    if (pipe(fds[i]))
+      die("pipe failed");
+
+  ev_loop_reserve(loop, 1024, RESERVED, RESERVED);
+  calls = c.calls;
+
+  /* everything up to the reservation fits without growing */
+  for (i = 0; i < FDS; ++i) {
+    ev_io_init(&ios[i], io_cb, fds[i][0], EV_READ);
+    ev_io_start(loop, &ios[i]);
+  }
+
+  start_and_feed(loop, RESERVED, timer_cb);
+  ev_run(loop, EVRUN_NOWAIT);
+
+  if (c.calls != calls)
+    die("loop allocated memory below its reservation");
+
+  if (fired != RESERVED)
+    die("fed timers were not invoked");
+
+  stop_all(loop, RESERVED);
+
+  /* a peak grows the arrays, trimming gives the memory back */
+  start_and_feed(loop, PEAK, timer_cb);
+  ev_run(loop, EVRUN_NOWAIT);
+  stop_all(loop, PEAK);
+  peak = c.bytes;
+
+  ev_loop_trim(loop);
+
+  if (c.bytes >= peak - (long)(PEAK - RESERVED) * 8)
+    die("ev_loop_trim did not shrink after a peak");
+
+  /* but not below the reservation */
+  calls = c.calls;
+  start_and_feed(loop, RESERVED, timer_cb);
+  ev_run(loop, EVRUN_NOWAIT);
+  stop_all(loop, RESERVED);
+
+  if (c.calls != calls)
+    die("ev_loop_trim shrank below the reservation");
+
+  ev_verify(loop);
+
+  for (i = 0; i < FDS; ++i) {
+    ev_io_stop(loop, &ios[i]);
+    close(fds[i][0]);
+    close(fds[i][1]);
+  }
+
+  ev_loop_destroy(loop);
+
+  if (c.bytes)
+    die("loop memory leaked");
+}
+
+static void test_trim_in_callback(void) {
+  struct ev_loop* loop = ev_loop_new(EVFLAG_AUTO);
+
+  if (!loop)
+    die("ev_loop_new failed");
+
+  /* grow the pending array, then trim it while it is being invoked */
+  start_and_feed(loop, PEAK, timer_cb);
+  ev_run(loop, EVRUN_NOWAIT);
+  stop_all(loop, PEAK);
+
+  fired = 0;
+  start_and_feed(loop, 1000, trimming_cb);
+  ev_run(loop, EVRUN_NOWAIT);
+
+  if (fired != 1000)
+    die("pending watchers got lost when trimming from a callback");
+
+  stop_all(loop, 1000);
+  ev_verify(loop);
+  ev_loop_destroy(loop);
+}
+
+int main(void) {
+  test_reserve_and_trim();
+  test_trim_in_callback();
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,127 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "ev.h"
+
+#define PAIRS 3
+
+static int fds[PAIRS][2];
+static ev_io ios[PAIRS];
+static ev_timer timer;
+static ev_async async;
+static int async_called;
+
+static void die(const char* msg) {
+  fprintf(stderr, "%s\n", msg);
+  exit(EXIT_FAILURE);
+}
+
+static void async_cb(EV_P_ ev_async* w, int revents) {
+  (void)loop;
+  (void)w;
+
+  if (!(revents & EV_ASYNC))
+    die("async callback without EV_ASYNC");
+
+  ++async_called;
+}
+
+static int io_index(ev_watcher* w) {
+  int i;
+
+  for (i = 0; i < PAIRS; ++i)
+    if (w == (ev_watcher*)&ios[i])
+      return i;
+
+  die("ev_poll_ready returned a foreign watcher");
+  return -1;
+}
+
+int main(void) {
+  struct ev_loop* loop = ev_loop_new(EVFLAG_AUTO);
+  ev_ready ready[PAIRS + 1];
+  int seen[PAIRS] = {0};
+  ev_tstamp start;
+  char c;
+  int i, n;
+
+  if (!loop)
+    die("ev_loop_new failed");
+
+  for (i = 0; i < PAIRS; ++i) {
+    if (socketpair(AF_UNIX, SOCK_STREAM, 0, fds[i]))
+      die("socketpair failed");
+
+    /* no callback: handed out by ev_poll_ready */
+    ev_io_init(&ios[i], 0, fds[i][0], EV_READ);
+    ev_io_start(loop, &ios[i]);
+  }
+
+  ev_async_init(&async, async_cb);
+  ev_async_start(loop, &async);
+
+  /* nothing ready: waits for the timeout */
+  start = ev_time();
+
+  if (ev_poll_ready(loop, ready, PAIRS, 0.05) != 0)
+    die("ev_poll_ready returned watchers without events");
+
+  if (ev_time() - start < 0.04)
+    die("ev_poll_ready did not wait");
+
+  for (i = 0; i < PAIRS; ++i)
+    if (write(fds[i][1], "x", 1) != 1)
+      die("write failed");
+
+  /* watchers with callbacks get invoked, not returned */
+  ev_async_send(loop, &async);
+
+  /* more ready than fit: the rest comes with the next call */
+  n = ev_poll_ready(loop, ready, 2, 1.);
+
+  if (n != 2)
+    die("ev_poll_ready did not fill the array");
+
+  n += ev_poll_ready(loop, ready + 2, PAIRS + 1 - 2, 0.);
+
+  if (n != PAIRS)
+    die("ev_poll_ready lost a ready watcher");
+
+  for (i = 0; i < PAIRS; ++i) {
+    int j = io_index(ready[i].w);
+
+    if (ready[i].revents != EV_READ || seen[j]++)
+      die("ev_poll_ready returned a watcher twice or with the wrong events");
+
+    if (ev_is_pending(ready[i].w))
+      die("returned watcher is still pending");
+
+    if (read(fds[j][0], &c, 1) != 1)
+      die("read failed");
+  }
+
+  if (async_called != 1)
+    die("watcher with callback was not invoked");
+
+  /* timers work as well */
+  ev_timer_init(&timer, 0, 0.01, 0.);
+  ev_timer_start(loop, &timer);
+
+  n = ev_poll_ready(loop, ready, PAIRS + 1, 1.);
+
+  if (n != 1 || ready[0].w != (ev_watcher*)&timer || ready[0].revents != EV_TIMER || ev_is_active(&timer))
+    die("ev_poll_ready did not return the expired timer");
+
+  for (i = 0; i < PAIRS; ++i) {
+    ev_io_stop(loop, &ios[i]);
+    close(fds[i][0]);
+    close(fds[i][1]);
+  }
+
+  ev_async_stop(loop, &async);
+  ev_loop_destroy(loop);
+
+  return EXIT_SUCCESS;
+}
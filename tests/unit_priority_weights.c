@@ -0,0 +1,122 @@
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "ev.h"
+
+#define LOWS 10
+#define HIGH_WEIGHT 4
+
+static ev_idle high;
+static ev_idle lows[LOWS];
+static int high_runs;
+static int low_runs;
+static int high_before_first_low = -1;
+
+static void die(const char* msg) {
+  fprintf(stderr, "%s\n", msg);
+  exit(EXIT_FAILURE);
+}
+
+/* a flooding high priority source: re-queues itself until the lows are done */
+static void high_cb(EV_P_ ev_idle* w, int revents) {
+  (void)revents;
+
+  ++high_runs;
+
+  if (low_runs < LOWS)
+    ev_feed_event(EV_A_ w, EV_CUSTOM);
+}
+
+static void low_cb(EV_P_ ev_idle* w, int revents) {
+  (void)loop;
+  (void)w;
+  (void)revents;
+
+  if (!low_runs++)
+    high_before_first_low = high_runs;
+}
+
+static void queue_all(struct ev_loop* loop) {
+  int i;
+
+  high_runs = 0;
+  low_runs = 0;
+  high_before_first_low = -1;
+
+  for (i = 0; i < LOWS; ++i)
+    ev_feed_event(loop, &lows[i], EV_CUSTOM);
+
+  ev_feed_event(loop, &high, EV_CUSTOM);
+}
+
+int main(void) {
+  struct ev_loop* loop = ev_loop_new(EVFLAG_AUTO);
+  int i;
+
+  if (!loop)
+    die("ev_loop_new failed");
+
+  ev_idle_init(&high, high_cb);
+  ev_set_priority(&high, EV_MAXPRI);
+
+  for (i = 0; i < LOWS; ++i) {
+    ev_idle_init(&lows[i], low_cb);
+    ev_set_priority(&lows[i], EV_MINPRI);
+  }
+
+  /* strict priorities: one high callback per low one would never end, so flood only once */
+  ev_feed_event(loop, &lows[0], EV_CUSTOM);
+  ev_feed_event(loop, &high, EV_CUSTOM);
+  low_runs = LOWS; /* keep high_cb from re-queueing */
+  ev_invoke_pending(loop);
+
+  if (high_runs != 1 || low_runs != LOWS + 1)
+    die("strict priority dispatch did not run everything");
+
+  ev_set_priority_weight(loop, EV_MAXPRI, HIGH_WEIGHT);
+  ev_set_priority_weight(loop, EV_MINPRI, 1);
+
+  queue_all(loop);
+  ev_invoke_pending(loop);
+  ev_verify(loop);
+
+  if (low_runs != LOWS)
+    die("low priority watchers were starved by the flood");
+
+  if (high_before_first_low < 1 || high_before_first_low > HIGH_WEIGHT)
+    die("weighted round did not start with the high priority");
+
+  if (high_runs < (LOWS - 1) * HIGH_WEIGHT || high_runs > (LOWS + 1) * HIGH_WEIGHT)
+    die("high priority did not get its weighted share");
+
+  if (ev_pending_count(loop))
+    die("watchers left pending after ev_invoke_pending");
+
+  /* all weights zero restores strict priorities */
+  ev_set_priority_weight(loop, EV_MAXPRI, 0);
+  ev_set_priority_weight(loop, EV_MINPRI, 0);
+
+  high_runs = 0;
+  low_runs = 0;
+  ev_feed_event(loop, &lows[0], EV_CUSTOM);
+  ev_feed_event(loop, &lows[1], EV_CUSTOM);
+  ev_feed_event(loop, &high, EV_CUSTOM);
+
+  /* high_cb re-queues itself until the lows ran, which they never do first */
+  ev_set_invoke_budget(loop, 50, 0.);
+  ev_invoke_pending(loop);
+
+  if (low_runs || high_runs != 50)
+    die("strict priorities did not prefer the high priority");
+
+  ev_set_invoke_budget(loop, 0, 0.);
+  ev_clear_pending(loop, &high);
+  ev_invoke_pending(loop);
+
+  if (low_runs != 2)
+    die("low priority watchers lost after clearing the flood");
+
+  ev_loop_destroy(loop);
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,125 @@
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include "ev.h"
+
+#define BYTES 5
+
+static int fds[2];
+static ev_io reader;
+static int reads;
+static int eagains;
+static int calls;
+
+static void die(const char* msg) {
+  fprintf(stderr, "%s\n", msg);
+  exit(EXIT_FAILURE);
+}
+
+/* reads one byte per invocation, like a reader with a small buffer */
+static void reader_cb(EV_P_ ev_io* w, int revents) {
+  char c;
+
+  if (revents != EV_READ)
+    die("speculative watcher got unexpected events");
+
+  ++calls;
+
+  if (read(fds[0], &c, 1) == 1)
+    ++reads;
+  else if (errno == EAGAIN) {
+    ++eagains;
+    ev_io_eagain(EV_A_ w);
+  }
+  else
+    die("read failed");
+}
+
+static void run_nowait(struct ev_loop* loop, int n) {
+  while (n--)
+    ev_run(loop, EVRUN_NOWAIT);
+}
+
+int main(void) {
+  struct ev_loop* loop = ev_loop_new(EVFLAG_AUTO);
+  char buf[BYTES] = {0};
+
+  if (!loop)
+    die("ev_loop_new failed");
+
+  if (pipe(fds) || fcntl(fds[0], F_SETFL, O_NONBLOCK))
+    die("pipe failed");
+
+  ev_io_init(&reader, reader_cb, fds[0], EV_READ | EV_SPECULATIVE);
+  ev_io_start(loop, &reader);
+
+  if (!(reader.events & EV_SPECULATIVE))
+    die("ev_io_start dropped EV_SPECULATIVE");
+
+  run_nowait(loop, 3);
+
+  if (calls)
+    die("speculative watcher invoked before the fd was ready");
+
+  if (write(fds[1], buf, BYTES) != BYTES)
+    die("write failed");
+
+  /* one kernel event, then invoked every iteration until EAGAIN */
+  run_nowait(loop, BYTES + 1);
+
+  if (reads != BYTES || eagains != 1 || calls != BYTES + 1)
+    die("speculative watcher not re-invoked until EAGAIN");
+
+  /* after EAGAIN, the kernel decides again */
+  run_nowait(loop, 3);
+
+  if (calls != BYTES + 1)
+    die("speculative watcher invoked after ev_io_eagain");
+
+  if (write(fds[1], buf, 2) != 2)
+    die("write failed");
+
+  run_nowait(loop, 3);
+
+  if (reads != BYTES + 2 || eagains != 2)
+    die("speculative watcher did not pick up new data");
+
+  /* stopping a hot watcher takes it off the hot list */
+  if (write(fds[1], buf, 1) != 1)
+    die("write failed");
+
+  ev_run(loop, EVRUN_NOWAIT);
+  ev_io_stop(loop, &reader);
+  ev_verify(loop);
+  calls = 0;
+  run_nowait(loop, 3);
+
+  if (calls)
+    die("stopped speculative watcher still invoked");
+
+  /* plain watchers are unaffected */
+  if (write(fds[1], buf, 1) != 1)
+    die("write failed");
+
+  ev_io_init(&reader, reader_cb, fds[0], EV_READ);
+  ev_io_start(loop, &reader);
+  ev_run(loop, EVRUN_NOWAIT);
+
+  if (calls != 1 || reads != BYTES + 4)
+    die("plain watcher misbehaved");
+
+  ev_run(loop, EVRUN_NOWAIT);
+
+  if (calls != 1)
+    die("plain watcher invoked without data");
+
+  ev_io_stop(loop, &reader);
+  close(fds[0]);
+  close(fds[1]);
+  ev_loop_destroy(loop);
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,192 @@
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "ev.h"
+
+#define WORK_COUNT 1000
+
+typedef struct {
+  ev_work w;
+  int input;
+  int output;
+  pthread_t ran_on;
+} job;
+
+static job jobs[WORK_COUNT];
+static pthread_t loop_thread;
+static int completed;
+static int cancelled_ran;
+static int fork_done;
+
+static void die(const char* msg) {
+  fprintf(stderr, "%s\n", msg);
+  exit(EXIT_FAILURE);
+}
+
+static void square(ev_work* w) {
+  job* j = (job*)w;
+
+  j->ran_on = pthread_self();
+  j->output = j->input * j->input;
+}
+
+static void done_cb(EV_P_ ev_work* w, int revents) {
+  job* j = (job*)w;
+
+  (void)loop;
+
+  if (!(revents & EV_WORK))
+    die("work callback without EV_WORK");
+
+  if (!pthread_equal(pthread_self(), loop_thread))
+    die("completion was not delivered on the loop thread");
+
+  if (pthread_equal(j->ran_on, loop_thread))
+    die("work function ran on the loop thread");
+
+  if (j->output != j->input * j->input)
+    die("work function result missing");
+
+  if (ev_is_active(w))
+    die("finished work watcher still active");
+
+  ++completed;
+}
+
+static void never_cb(EV_P_ ev_work* w, int revents) {
+  (void)loop;
+  (void)w;
+  (void)revents;
+
+  die("callback of a stopped work watcher was invoked");
+}
+
+static void slow(ev_work* w) {
+  (void)w;
+
+  ++cancelled_ran;
+  ev_sleep(0.01);
+}
+
+static void fork_cb(EV_P_ ev_work* w, int revents) {
+  (void)loop;
+  (void)w;
+  (void)revents;
+
+  ++fork_done;
+}
+
+static void test_fork(struct ev_loop* loop) {
+  ev_work pending[8];
+  int status;
+  pid_t pid;
+  int i;
+
+  /* some of these run, the rest wait in the queues while forking */
+  for (i = 0; i < 8; ++i) {
+    ev_work_init(&pending[i], fork_cb, slow);
+    ev_work_start(loop, &pending[i]);
+  }
+
+  pid = fork();
+
+  if (pid < 0)
+    die("fork failed");
+
+  if (!pid) {
+    alarm(5);
+    ev_loop_fork(loop);
+
+    /* the child has no pool threads, its copies come back cancelled */
+    ev_run(loop, 0);
+
+    for (i = 0; i < 8; ++i)
+      if (ev_is_active(&pending[i]))
+        _exit(1);
+
+    if (fork_done)
+      _exit(2);
+
+    /* and the pool starts again on demand */
+    completed = 0;
+    jobs[0].input = 7;
+    ev_work_init(&jobs[0].w, done_cb, square);
+    ev_work_start(loop, &jobs[0].w);
+    ev_run(loop, 0);
+
+    _exit(completed == 1 ? 0 : 3);
+  }
+
+  if (waitpid(pid, &status, 0) != pid || !WIFEXITED(status) || WEXITSTATUS(status))
+    die("ev_work did not recover in a forked child");
+
+  ev_run(loop, 0);
+
+  if (fork_done != 8)
+    die("work outstanding at fork time did not complete in the parent");
+}
+
+static void test_completions(struct ev_loop* loop) {
+  int i;
+
+  for (i = 0; i < WORK_COUNT; ++i) {
+    jobs[i].input = i;
+    ev_work_init(&jobs[i].w, done_cb, square);
+    ev_work_start(loop, &jobs[i].w);
+  }
+
+  /* the loop stays alive while work is outstanding */
+  ev_run(loop, 0);
+
+  if (completed != WORK_COUNT)
+    die("not all work completions were delivered");
+}
+
+static void test_stop(struct ev_loop* loop) {
+  ev_work blockers[4];
+  ev_work victims[16];
+  int i;
+
+  /* keep the pool busy so the victims are still queued when stopped */
+  for (i = 0; i < 4; ++i) {
+    ev_work_init(&blockers[i], never_cb, slow);
+    ev_work_start(loop, &blockers[i]);
+    ev_work_stop(loop, &blockers[i]);
+  }
+
+  for (i = 0; i < 16; ++i) {
+    ev_work_init(&victims[i], never_cb, square);
+    ev_work_start(loop, &victims[i]);
+    ev_work_stop(loop, &victims[i]);
+
+    if (!ev_is_active(&victims[i]))
+      die("stopped work watcher became inactive before the pool returned it");
+  }
+
+  ev_run(loop, 0);
+
+  for (i = 0; i < 16; ++i)
+    if (ev_is_active(&victims[i]))
+      die("stopped work watcher never became inactive");
+}
+
+int main(void) {
+  struct ev_loop* loop = ev_loop_new(EVFLAG_AUTO);
+
+  if (!loop)
+    die("ev_loop_new failed");
+
+  loop_thread = pthread_self();
+  ev_set_work_threads(3);
+
+  test_completions(loop);
+  test_stop(loop);
+  test_fork(loop);
+
+  ev_loop_destroy(loop);
+
+  return EXIT_SUCCESS;
+}